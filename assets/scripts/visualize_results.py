@@ -1,33 +1,43 @@
-# Script to plot the results
+# Script to plot the results written by ./bench
+import csv
+import sys
+from collections import defaultdict
+
 import matplotlib.pyplot as plt
 
-# Example runtime data (replace these with your actual data)
-dimensions = ["4x4", "5x5", "6x6", "7x7", "8x8", "9x9", "10x10"]
-bestfs = [0.5788, 61.1732, 91.3431, 269.9811]  # only till 6x6
-extrapolated_bestfs = [0.5788, 61.1732, 91.3431, 269.9811, 622.273]
-plits_parr = [0.2357, 1.2872, 8.6459, 50.7565, 99.1762, 251.1907, 362.2763]
-mis_parr = [0.0081, 0.0286, 0.0407, 0.2699, 3.936, 52.2047, 207.0122]  # proposed algorithm
+# Usage: python3 visualize_results.py [results.csv] [plot.png]
+path = sys.argv[1] if len(sys.argv) > 1 else "results.csv"
+output = sys.argv[2] if len(sys.argv) > 2 else None
+
+# Median and p90 runtime per algorithm and order, averaged over the instances of an order.
+# Orders where an algorithm solved no run are left out.
+runs = defaultdict(lambda: defaultdict(list))
+with open(path) as f:
+    for row in csv.DictReader(f):
+        if float(row["success_rate"]) == 0:
+            continue
+        runs[row["algorithm"]][int(row["order"])].append((float(row["median_s"]), float(row["p90_s"])))
 
 # Plotting
 plt.figure(figsize=(8, 6))
 
-# Plot for Algorithm 1 (up to 6x6)
-plt.plot(dimensions[:4], bestfs, label='BestFS', color='blue', marker='o')
-plt.plot(dimensions[:5], extrapolated_bestfs, label='BestFS extrapolated', color='blue', linestyle='--')
-
-# Plot for Algorithm 2 (all dimensions)
-plt.plot(dimensions, plits_parr, label='PLITS Parallel', color='red', marker='s')
-
-# Plot for Algorithm 3 (all dimensions, green for proposed algorithm)
-plt.plot(dimensions, mis_parr, label='MIS Parallel', color='green', marker='^')
+for algorithm, orders in runs.items():
+    x = sorted(orders)
+    median = [sum(m for m, _ in orders[n]) / len(orders[n]) for n in x]
+    p90 = [sum(p for _, p in orders[n]) / len(orders[n]) for n in x]
+    line, = plt.plot(x, median, label=algorithm, marker='o')
+    plt.fill_between(x, median, p90, color=line.get_color(), alpha=0.15)
 
 # Adding titles and labels
-plt.title('Runtime Comparison of Algorithms')
+plt.title('Runtime Comparison of Algorithms (median, shaded up to p90)')
 plt.xlabel('Dimension (n x n)')
 plt.ylabel('Runtime (seconds)')
-plt.xticks(dimensions)  # ensures each dimension value appears on the x-axis
+plt.yscale('log')
 plt.legend()
 
 # Display the plot
 plt.grid(True)
-plt.show()
+if output:
+    plt.savefig(output)
+else:
+    plt.show()
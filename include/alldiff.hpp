@@ -0,0 +1,268 @@
+#ifndef ALLDIFF_HPP
+#define ALLDIFF_HPP
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "domain.hpp"
+#include "propagate.hpp"
+
+using namespace std;
+
+/**
+ * @brief Generalised arc consistency for the all-different constraint of every row and column (Régin).
+ *
+ * A row or column with k empty cells misses exactly k symbols, so a solution of the unit
+ * is a perfect matching between its empty cells and its missing symbols. A symbol can be
+ * kept in a cell iff the edge is in some perfect matching: it is matched, or the cell and
+ * the cell matched to the symbol lie in the same strongly connected component of the
+ * alternating graph. Units are queued when one of their cells changes, and the matching
+ * of a unit is kept between calls so that only broken edges need augmenting.
+ */
+class AllDiff {
+public:
+    int x = 0; // Order of the square
+    long calls = 0; // Calls to filter()
+    long units = 0; // Units filtered
+    long removed = 0; // Symbols removed from cell domains
+    double seconds = 0; // Time spent in filter()
+    vector<pair<int, int>> pruned; // (cell index, symbol) of every erased value, until the caller clears it
+
+    /**
+     * @brief Creates a filter for squares of the given order. Every unit starts queued.
+     */
+    AllDiff(int order) : x(order), match(2 * order, vector<int>(order, 0)), queued(2 * order, 0) {
+        touch_all();
+    }
+
+    /**
+     * @brief Queues the row and the column of a cell whose domain or value changed.
+     */
+    void touch(pair<int, int> v) {
+        push(v.first);
+        push(x + v.second);
+    }
+
+    /**
+     * @brief Queues the units affected by placing the value of cell v.
+     *
+     * Besides the row and column of v, every empty neighbour that could hold the symbol
+     * loses it, so its crossing unit is queued as well.
+     */
+    void placed(const Domain& D, const vector<vector<int>>& square, pair<int, int> v) {
+        int i = v.first, j = v.second, s = square[i][j];
+        touch(v);
+        for (int k = 0; k < x; k++) {
+            if (square[i][k] == 0 && (D.cells[i * x + k] >> s & 1)) push(x + k);
+            if (square[k][j] == 0 && (D.cells[k * x + j] >> s & 1)) push(k);
+        }
+    }
+
+    /**
+     * @brief Queues every row and column.
+     */
+    void touch_all() {
+        for (int u = 0; u < 2 * x; u++) push(u);
+    }
+
+    /**
+     * @brief Drops every queued unit.
+     */
+    void clear() {
+        for (int u : worklist) queued[u] = 0;
+        worklist.clear();
+    }
+
+    /**
+     * @brief Filters the queued units until no domain changes.
+     *
+     * @param D The domain store; symbols without support are erased from it.
+     * @param square The square, 0 for an empty cell.
+     * @return false if some unit has no perfect matching, true otherwise.
+     */
+    bool filter(Domain& D, const vector<vector<int>>& square) {
+        auto start = chrono::steady_clock::now();
+        calls++;
+        bool ok = true;
+        while (!worklist.empty() && ok) {
+            int u = worklist.back();
+            worklist.pop_back();
+            queued[u] = 0;
+            units++;
+            ok = filter_unit(D, square, u);
+        }
+        if (!ok) clear();
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return ok;
+    }
+
+    /**
+     * @brief Prints the filtering cost.
+     */
+    void report() const {
+        cout << "All-different: " << calls << " calls, " << units << " units, " << removed << " values removed, "
+             << (calls ? seconds * 1e6 / calls : 0) << "us per call\n";
+    }
+
+private:
+    vector<vector<int>> match; // match[u][k]: symbol matched to position k of unit u, 0 if none
+    vector<char> queued; // Whether each unit is in the worklist
+    vector<int> worklist; // Units 0..x-1 are rows, x..2x-1 are columns
+
+    // Scratch space of the current unit
+    vector<int> pos; // Position in the unit of every empty cell
+    vector<uint64_t> dom; // Live domain of every empty cell
+    int val_of[64]; // Cell index matched to every symbol, -1 if none
+    vector<uint64_t> adj; // Alternating graph over cells
+    vector<int> index, low, comp, stack;
+    uint64_t on_stack = 0;
+    int counter = 0, comps = 0;
+
+    void push(int u) {
+        if (!queued[u]) {
+            queued[u] = 1;
+            worklist.push_back(u);
+        }
+    }
+
+    pair<int, int> cell(int u, int k) const {
+        return (u < x) ? make_pair(u, k) : make_pair(k, u - x);
+    }
+
+    /**
+     * @brief Tries to match cell a along an augmenting path (Kuhn).
+     */
+    bool augment(int a, uint64_t& seen, vector<int>& sym) {
+        for (uint64_t m = dom[a] & ~seen; m; m &= m - 1) {
+            int s = __builtin_ctzll(m);
+            seen |= uint64_t(1) << s;
+            if (val_of[s] < 0 || augment(val_of[s], seen, sym)) {
+                val_of[s] = a;
+                sym[a] = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Tarjan's strongly connected components over the cells of the unit.
+     */
+    void tarjan(int a) {
+        index[a] = low[a] = counter++;
+        stack.push_back(a);
+        on_stack |= uint64_t(1) << a;
+        for (uint64_t m = adj[a]; m; m &= m - 1) {
+            int b = __builtin_ctzll(m);
+            if (index[b] < 0) {
+                tarjan(b);
+                low[a] = min(low[a], low[b]);
+            } else if (on_stack >> b & 1) {
+                low[a] = min(low[a], index[b]);
+            }
+        }
+        if (low[a] == index[a]) {
+            int b;
+            do {
+                b = stack.back();
+                stack.pop_back();
+                on_stack &= ~(uint64_t(1) << b);
+                comp[b] = comps;
+            } while (b != a);
+            comps++;
+        }
+    }
+
+    bool filter_unit(Domain& D, const vector<vector<int>>& square, int u) {
+        pos.clear();
+        dom.clear();
+        for (int k = 0; k < x; k++) {
+            pair<int, int> v = cell(u, k);
+            if (square[v.first][v.second] != 0) continue;
+            pos.push_back(k);
+            dom.push_back(D.mask(v) & ~uint64_t(1));
+        }
+        int n = pos.size();
+        if (n == 0) return true;
+
+        // Keep the matched edges that are still valid, then augment the rest
+        vector<int> sym(n, 0);
+        fill(val_of, val_of + 64, -1);
+        for (int a = 0; a < n; a++) {
+            int s = match[u][pos[a]];
+            if (s != 0 && (dom[a] >> s & 1) && val_of[s] < 0) {
+                sym[a] = s;
+                val_of[s] = a;
+            }
+        }
+        for (int a = 0; a < n; a++) {
+            uint64_t seen = 0;
+            if (sym[a] == 0 && !augment(a, seen, sym)) return false;
+        }
+        for (int k = 0; k < x; k++) match[u][k] = 0;
+        for (int a = 0; a < n; a++) match[u][pos[a]] = sym[a];
+
+        uint64_t values = 0;
+        for (int a = 0; a < n; a++) values |= dom[a];
+        if (__builtin_popcountll(values) != n) return true; // Clashing givens leave free symbols
+
+        // Cell a points to every cell matched to another symbol of its domain
+        adj.assign(n, 0);
+        for (int a = 0; a < n; a++) {
+            for (uint64_t m = dom[a] & ~(uint64_t(1) << sym[a]); m; m &= m - 1) {
+                adj[a] |= uint64_t(1) << val_of[__builtin_ctzll(m)];
+            }
+        }
+        index.assign(n, -1);
+        low.assign(n, 0);
+        comp.assign(n, 0);
+        stack.clear();
+        on_stack = 0;
+        counter = comps = 0;
+        for (int a = 0; a < n; a++) {
+            if (index[a] < 0) tarjan(a);
+        }
+        if (comps == 1) return true; // Every edge lies on an alternating cycle
+
+        // Drop the edges that leave a component
+        for (int a = 0; a < n; a++) {
+            pair<int, int> v = cell(u, pos[a]);
+            for (uint64_t m = dom[a] & ~(uint64_t(1) << sym[a]); m; m &= m - 1) {
+                int s = __builtin_ctzll(m);
+                if (comp[val_of[s]] == comp[a]) continue;
+                D.erase(v, s);
+                removed++;
+                pruned.push_back({v.first * x + v.second, s});
+                push(u < x ? x + v.second : v.first); // The crossing unit lost a candidate
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Runs singles propagation and all-different filtering to a common fixpoint.
+ *
+ * @param D The domain store.
+ * @param square The square, 0 for an empty cell. Forced cells are filled in.
+ * @param P The singles propagator; it is told about every value the filter erases.
+ * @param A The all-different filter; its queued units are filtered first.
+ * @param fixed Receives every cell filled by the propagation.
+ * @return false if a contradiction was found, true otherwise.
+ */
+bool propagate(Domain& D, vector<vector<int>>& square, Propagator& P, AllDiff& A, vector<pair<int, int>>& fixed) {
+    while (true) {
+        size_t before = fixed.size();
+        if (!P.run(D, square, fixed)) {
+            A.clear();
+            return false;
+        }
+        for (size_t k = before; k < fixed.size(); k++) A.placed(D, square, fixed[k]);
+        A.pruned.clear();
+        if (!A.filter(D, square)) return false;
+        if (A.pruned.empty()) return true;
+        for (auto& e : A.pruned) P.erased(D, {e.first / A.x, e.first % A.x}, e.second);
+    }
+}
+
+#endif
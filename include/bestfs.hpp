@@ -0,0 +1,41 @@
+#ifndef BESTFS_HPP
+#define BESTFS_HPP
+
+#include "lsc.hpp"
+
+using namespace std;
+
+/**
+ * @brief Performs a Best-First Search (BestFS) on the given Latin square coloring problem.
+ *
+ * This is the search of the bestfs target, and the sequential baseline bestfs_par reports
+ * its speedup against.
+ *
+ * @param S The initial LSC instance to start the search from.
+ * @param goal Receives the solution, if one is found.
+ * @param steps Set to the number of states expanded.
+ * @return true if a solution was found.
+ */
+bool BestFS(LSC S, LSC& goal, long& steps) {
+    steps = 0;
+    vector<Node> nodes = {{-1, 0, 0, 0, 0}};
+    priority_queue<pair<int, int>, vector<pair<int, int>>, Compare> Open;
+    Open.push({0, -S.CL()});
+
+    HashSet Close;
+    Close.insert(S.hash);
+    int curr_id = -1;
+
+    while(!Open.empty()) {
+        int id = Open.top().first;
+        Open.pop();
+        steps++;
+        rebuild(S, nodes, id, goal, curr_id);
+        if (goal.GoalTest()) return true;
+
+        goal.MoveGen(id, nodes, Open, Close);
+    }
+    return false;
+}
+
+#endif
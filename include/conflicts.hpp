@@ -0,0 +1,101 @@
+#ifndef CONFLICTS_HPP
+#define CONFLICTS_HPP
+
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @brief Incremental conflict counter for a coloured Latin square.
+ *
+ * Keeps how often every symbol occurs in every row and column, together with the
+ * number of conflicting pairs (two cells of one row or column sharing a symbol).
+ * Symbol 0 marks an empty cell and never conflicts.
+ */
+class Conflicts {
+public:
+    int x = 0; // Order of the square
+    vector<int> row_cnt; // row_cnt[i * (x + 1) + c]: occurrences of c in row i
+    vector<int> col_cnt; // col_cnt[j * (x + 1) + c]: occurrences of c in column j
+    int total = 0; // Number of conflicting pairs
+
+    /**
+     * @brief Default constructor.
+     */
+    Conflicts() {
+        ;
+    }
+
+    /**
+     * @brief Creates an empty counter for a square of the given order.
+     *
+     * @param order The order of the square.
+     */
+    Conflicts(int order) : x(order), row_cnt(order * (order + 1), 0), col_cnt(order * (order + 1), 0) {
+        ;
+    }
+
+    /**
+     * @brief Builds a counter from a complete or partial square.
+     *
+     * @param square The square to count.
+     */
+    Conflicts(const vector<vector<int>>& square) : Conflicts((int)square.size()) {
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) {
+                add({i, j}, square[i][j]);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns how many cells in the row and column of v hold symbol c.
+     *
+     * If v itself holds c it is counted twice, once for its row and once for its column.
+     */
+    int at(pair<int, int> v, int c) const {
+        return row_cnt[v.first * (x + 1) + c] + col_cnt[v.second * (x + 1) + c];
+    }
+
+    /**
+     * @brief Records that cell v now holds symbol c.
+     */
+    void add(pair<int, int> v, int c) {
+        if (c == 0) return;
+        total += at(v, c);
+        row_cnt[v.first * (x + 1) + c]++;
+        col_cnt[v.second * (x + 1) + c]++;
+    }
+
+    /**
+     * @brief Records that cell v no longer holds symbol c.
+     */
+    void remove(pair<int, int> v, int c) {
+        if (c == 0) return;
+        row_cnt[v.first * (x + 1) + c]--;
+        col_cnt[v.second * (x + 1) + c]--;
+        total -= at(v, c);
+    }
+
+    /**
+     * @brief Records a recolouring of v from c1 to c2.
+     */
+    void move(pair<int, int> v, int c1, int c2) {
+        remove(v, c1);
+        add(v, c2);
+    }
+
+    /**
+     * @brief Returns the change in conflicts if v were recoloured from c1 to c2.
+     */
+    int delta(pair<int, int> v, int c1, int c2) const {
+        if (c1 == c2) return 0;
+        int res = 0;
+        if (c1 != 0) res -= at(v, c1) - 2; // v no longer clashes with its own row and column
+        if (c2 != 0) res += at(v, c2);
+        return res;
+    }
+};
+
+#endif
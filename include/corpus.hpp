@@ -0,0 +1,261 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief Binary corpus of partial Latin squares.
+ *
+ * Layout, all integers little-endian:
+ *  - header: magic "LSCB", version (uint32), instance count (uint64), offset of the index (uint64)
+ *  - records, each an order (uint16), a cell width in bytes (uint8, 1 or 2), a reserved byte
+ *    and order * order cells in row-major order
+ *  - index: the offset of every record (uint64)
+ *
+ * Cells are stored in one byte when the order is below 256.
+ */
+namespace corpus {
+
+const char MAGIC[4] = {'L', 'S', 'C', 'B'};
+const uint32_t VERSION = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t count; // Number of instances
+    uint64_t index; // Offset of the record index
+};
+
+struct Record {
+    uint16_t order;
+    uint8_t width; // Bytes per cell
+    uint8_t reserved;
+};
+
+/**
+ * @brief Zero-copy view of one instance of a mapped corpus.
+ */
+class View {
+public:
+    int order = 0;
+
+    /**
+     * @brief Views the record at p, which Reader::open() has bounds-checked.
+     */
+    View(const uint8_t* p) : cells(p + sizeof(Record)) {
+        Record r;
+        memcpy(&r, p, sizeof(r)); // Records are not aligned
+        order = r.order;
+        width = r.width;
+    }
+
+    /**
+     * @brief Returns the symbol of cell (i, j), 0 if it is empty.
+     */
+    int at(int i, int j) const {
+        int k = i * order + j;
+        if (width == 1) return cells[k];
+        uint16_t v;
+        memcpy(&v, cells + 2 * k, 2);
+        return v;
+    }
+
+    /**
+     * @brief Copies the instance into the square representation used by the solvers,
+     * reusing the storage of out when the order matches.
+     *
+     * @return false if a cell holds a symbol above the order, like read_instance().
+     */
+    bool square(vector<vector<int>>& out) const {
+        if ((int)out.size() != order) out.assign(order, vector<int>(order));
+        for (int i = 0; i < order; i++) {
+            for (int j = 0; j < order; j++) {
+                out[i][j] = at(i, j);
+                if (out[i][j] > order) return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    int width;
+    const uint8_t* cells;
+};
+
+/**
+ * @brief Read-only, memory-mapped corpus.
+ *
+ * Opening costs one mmap; instances are decoded on access, so threads can share one
+ * reader and split the corpus by index range.
+ */
+class Reader {
+public:
+    /**
+     * @brief Maps a corpus file and checks that the index and every record lie inside it.
+     *
+     * @return false if the file cannot be mapped, is not a corpus or is truncated.
+     */
+    bool open(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(Header)) {
+            close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return false;
+        base = static_cast<const uint8_t*>(p);
+        length = st.st_size;
+        const Header* h = reinterpret_cast<const Header*>(base);
+        if (memcmp(h->magic, MAGIC, 4) != 0 || h->version != VERSION || h->index % 8 != 0 || h->index > length
+            || h->count > (length - h->index) / 8) {
+            unmap();
+            return false;
+        }
+        index = reinterpret_cast<const uint64_t*>(base + h->index);
+        count = h->count;
+        for (size_t k = 0; k < count; k++) {
+            if (!valid(index[k])) {
+                unmap();
+                return false;
+            }
+        }
+        madvise(p, length, MADV_WILLNEED);
+        return true;
+    }
+
+    ~Reader() {
+        unmap();
+    }
+
+    /**
+     * @brief Returns the number of instances.
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Returns a view of the k-th instance.
+     */
+    View operator[](size_t k) const {
+        return View(base + index[k]);
+    }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    const uint64_t* index = nullptr;
+    size_t count = 0;
+
+    void unmap() {
+        if (base != nullptr) munmap(const_cast<uint8_t*>(base), length);
+        base = nullptr;
+        count = 0;
+    }
+
+    /**
+     * @brief Checks that the record at offset has a usable order and width and ends
+     * inside the file.
+     */
+    bool valid(uint64_t offset) const {
+        if (offset < sizeof(Header) || offset > length - sizeof(Record)) return false;
+        Record r;
+        memcpy(&r, base + offset, sizeof(r));
+        if (r.order < 1 || (r.width != 1 && r.width != 2)) return false;
+        return (uint64_t)r.order * r.order * r.width <= length - offset - sizeof(Record);
+    }
+};
+
+/**
+ * @brief Returns true if the file starts with the corpus magic.
+ */
+bool is_corpus(const string& path) {
+    ifstream in(path, ios::binary);
+    char magic[4];
+    return in.read(magic, 4) && memcmp(magic, MAGIC, 4) == 0;
+}
+
+/**
+ * @brief Streams instances into a corpus file. The index is written by close().
+ */
+class Writer {
+public:
+    /**
+     * @brief Creates the corpus file.
+     *
+     * @return false if the file cannot be created.
+     */
+    bool open(const string& path) {
+        out.open(path, ios::binary | ios::trunc);
+        if (!out) return false;
+        Header h = {};
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h)); // Patched by close()
+        offset = sizeof(h);
+        return true;
+    }
+
+    /**
+     * @brief Appends one instance.
+     */
+    void add(const vector<vector<int>>& square) {
+        int x = square.size();
+        Record r = {(uint16_t)x, (uint8_t)(x < 256 ? 1 : 2), 0};
+        vector<uint8_t> cells(x * x * r.width);
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) {
+                uint16_t v = square[i][j];
+                memcpy(&cells[(i * x + j) * r.width], &v, r.width);
+            }
+        }
+        index.push_back(offset);
+        out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        out.write(reinterpret_cast<const char*>(cells.data()), cells.size());
+        offset += sizeof(r) + cells.size();
+    }
+
+    /**
+     * @brief Writes the index and the header.
+     *
+     * @return The number of instances written.
+     */
+    size_t close() {
+        // Align the index so that the reader can use it in place
+        while (offset % 8 != 0) {
+            out.put(0);
+            offset++;
+        }
+        Header h;
+        memcpy(h.magic, MAGIC, 4);
+        h.version = VERSION;
+        h.count = index.size();
+        h.index = offset;
+        out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(uint64_t));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.close();
+        return index.size();
+    }
+
+private:
+    ofstream out;
+    vector<uint64_t> index;
+    uint64_t offset = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef DLX_HPP
+#define DLX_HPP
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Exact-cover solver for Latin square completion using Knuth's Algorithm X with dancing links.
+ *
+ * The 3n^2 columns are the constraints "cell (i, j) is filled", "row i holds symbol s" and
+ * "column j holds symbol s". Every option (i, j, s) is a row covering one column of each
+ * kind. Given cells are selected before the search starts.
+ */
+class DLX {
+public:
+    int x; // Order of the square
+    vector<vector<int>> square; // Partial square, completed by solve()
+    long nodes = 0; // Options tried during the search
+    bool consistent = true; // False if the givens already clash
+
+    /**
+     * @brief Builds the exact-cover matrix of a partial Latin square.
+     *
+     * @param partial The partial Latin square, 0 for an empty cell.
+     */
+    DLX(const vector<vector<int>>& partial) : x(partial.size()), square(partial) {
+        int cols = 3 * x * x;
+        // Node 0 is the root, nodes 1..cols are the column headers
+        for (int c = 0; c <= cols; c++) {
+            add_node(c);
+            L[c] = (c == 0) ? cols : c - 1;
+            R[c] = (c == cols) ? 0 : c + 1;
+        }
+        S.assign(cols + 1, 0);
+
+        vector<int> given;
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) {
+                for (int s = 1; s <= x; s++) {
+                    if (square[i][j] != 0 && square[i][j] != s) continue;
+                    int first = add_row(i, j, s);
+                    if (square[i][j] == s) given.push_back(first);
+                }
+            }
+        }
+
+        // Pre-select the givens
+        for (int first : given) {
+            for (int k = first;;) {
+                if (!active(C[k])) {
+                    consistent = false; // Two givens share a row or column symbol
+                    return;
+                }
+                k = R[k];
+                if (k == first) break;
+            }
+            select(first);
+        }
+    }
+
+    /**
+     * @brief Searches for a completion of the square.
+     *
+     * @return true if a completion was found; square then holds it.
+     */
+    bool solve() {
+        return consistent && search();
+    }
+
+private:
+    vector<int> L, R, U, D, C; // Links and column of every node
+    vector<int> S; // Number of nodes in each column
+    vector<int> option; // Option (i, j, s) of every node, packed as (i * x + j) * (x + 1) + s
+
+    int add_node(int c) {
+        int k = L.size();
+        L.push_back(k);
+        R.push_back(k);
+        U.push_back(k);
+        D.push_back(k);
+        C.push_back(c);
+        option.push_back(-1);
+        return k;
+    }
+
+    /**
+     * @brief Appends the option (i, j, s) and returns its first node.
+     */
+    int add_row(int i, int j, int s) {
+        int cols[3] = {1 + i * x + j, 1 + x * x + i * x + (s - 1), 1 + 2 * x * x + j * x + (s - 1)};
+        int first = -1;
+        for (int c : cols) {
+            int k = add_node(c);
+            option[k] = (i * x + j) * (x + 1) + s;
+            U[k] = U[c];
+            D[k] = c;
+            D[U[c]] = k;
+            U[c] = k;
+            S[c]++;
+            if (first < 0) {
+                first = k;
+            } else {
+                L[k] = L[first];
+                R[k] = first;
+                R[L[first]] = k;
+                L[first] = k;
+            }
+        }
+        return first;
+    }
+
+    bool active(int c) {
+        return R[L[c]] == c;
+    }
+
+    void cover(int c) {
+        R[L[c]] = R[c];
+        L[R[c]] = L[c];
+        for (int i = D[c]; i != c; i = D[i]) {
+            for (int j = R[i]; j != i; j = R[j]) {
+                U[D[j]] = U[j];
+                D[U[j]] = D[j];
+                S[C[j]]--;
+            }
+        }
+    }
+
+    void uncover(int c) {
+        for (int i = U[c]; i != c; i = U[i]) {
+            for (int j = L[i]; j != i; j = L[j]) {
+                S[C[j]]++;
+                U[D[j]] = j;
+                D[U[j]] = j;
+            }
+        }
+        R[L[c]] = c;
+        L[R[c]] = c;
+    }
+
+    /**
+     * @brief Covers every column of the option containing node r.
+     */
+    void select(int r) {
+        cover(C[r]);
+        for (int j = R[r]; j != r; j = R[j]) cover(C[j]);
+    }
+
+    bool search() {
+        if (R[0] == 0) return true; // Every constraint is covered
+
+        // Branch on the column with the fewest options
+        int c = R[0];
+        for (int k = R[c]; k != 0; k = R[k]) {
+            if (S[k] < S[c]) c = k;
+        }
+        if (S[c] == 0) return false;
+
+        cover(c);
+        for (int r = D[c]; r != c; r = D[r]) {
+            nodes++;
+            for (int j = R[r]; j != r; j = R[j]) cover(C[j]);
+            if (search()) {
+                int o = option[r];
+                square[o / (x + 1) / x][o / (x + 1) % x] = o % (x + 1);
+                return true;
+            }
+            for (int j = L[r]; j != r; j = L[j]) uncover(C[j]);
+        }
+        uncover(c);
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef DOMAIN_HPP
+#define DOMAIN_HPP
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+const int MAX_ORDER = 63; // Largest order whose symbols (plus 0) fit in a 64-bit mask
+
+/**
+ * @brief Flat bitmask domain store shared by all LSC variants.
+ *
+ * Bit k of a mask stands for symbol k. Every cell keeps its own mask, while every
+ * row and column keeps a mask of the symbols already placed in it. The live domain
+ * of a cell is its own mask minus the symbols used in its row and column, so placing
+ * a symbol prunes all 2(x - 1) neighbours with two OR operations.
+ */
+class Domain {
+public:
+    int x = 0; // Order of the square
+    vector<uint64_t> cells; // Per-cell symbol masks, row-major
+    vector<uint64_t> row_used; // Symbols placed in each row
+    vector<uint64_t> col_used; // Symbols placed in each column
+    vector<uint8_t> counts; // Singles counts kept by Propagator, empty until its first run
+
+    /**
+     * @brief Default constructor.
+     */
+    Domain() {
+        ;
+    }
+
+    /**
+     * @brief Creates a domain store where every cell starts with the same mask.
+     *
+     * @param order The order of the square.
+     * @param full The initial mask of every cell.
+     */
+    Domain(int order, uint64_t full) : x(order), cells(order * order, full), row_used(order, 0), col_used(order, 0) {
+        ;
+    }
+
+    /**
+     * @brief Returns the mask of all symbols in [lo, hi].
+     */
+    static uint64_t range(int lo, int hi) {
+        uint64_t upto = (hi >= 63) ? ~uint64_t(0) : ((uint64_t(1) << (hi + 1)) - 1);
+        return upto & ~((uint64_t(1) << lo) - 1);
+    }
+
+    /**
+     * @brief Returns the live domain of a cell as a bitmask.
+     */
+    uint64_t mask(pair<int, int> v) const {
+        return cells[v.first * x + v.second] & ~(row_used[v.first] | col_used[v.second]);
+    }
+
+    /**
+     * @brief Returns the number of symbols left in the domain of a cell.
+     */
+    int size(pair<int, int> v) const {
+        return __builtin_popcountll(mask(v));
+    }
+
+    /**
+     * @brief Checks if symbol k is still allowed in a cell.
+     */
+    bool contains(pair<int, int> v, int k) const {
+        return (mask(v) >> k) & 1;
+    }
+
+    /**
+     * @brief Returns the smallest symbol in the domain of a cell (domain must be non-empty).
+     */
+    int first(pair<int, int> v) const {
+        return __builtin_ctzll(mask(v));
+    }
+
+    /**
+     * @brief Returns the k-th smallest symbol (0-based) in the domain of a cell.
+     *
+     * @param v The cell.
+     * @param k The rank of the symbol, must be less than size(v).
+     */
+    int kth(pair<int, int> v, int k) const {
+        uint64_t m = mask(v);
+        for (; k > 0; k--) m &= m - 1; // Drop the k lowest symbols
+        return __builtin_ctzll(m);
+    }
+
+    /**
+     * @brief Removes a symbol from the domain of a single cell.
+     */
+    void erase(pair<int, int> v, int k) {
+        cells[v.first * x + v.second] &= ~(uint64_t(1) << k);
+    }
+
+    /**
+     * @brief Empties the domain of a cell.
+     */
+    void clear(pair<int, int> v) {
+        cells[v.first * x + v.second] = 0;
+    }
+
+    /**
+     * @brief Marks symbol k as used in the row and column of a cell.
+     *
+     * This removes k from the live domain of every cell sharing the row or column.
+     */
+    void place(pair<int, int> v, int k) {
+        row_used[v.first] |= uint64_t(1) << k;
+        col_used[v.second] |= uint64_t(1) << k;
+    }
+};
+
+#endif
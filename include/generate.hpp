@@ -0,0 +1,181 @@
+#ifndef GENERATE_HPP
+#define GENERATE_HPP
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cmath>
+
+using namespace std;
+
+/**
+ * @brief Seeded generator of random Latin squares and partial Latin squares.
+ *
+ * Uses its own bounded draws and shuffles on top of mt19937_64, so the same seed
+ * gives the same instances with every standard library.
+ */
+class Generator {
+public:
+    /**
+     * @brief Creates a generator. Each distinct list of seed words gives an independent stream.
+     */
+    Generator(const vector<uint32_t>& seed) {
+        seed_seq seq(seed.begin(), seed.end());
+        rng.seed(seq);
+    }
+
+    /**
+     * @brief Returns a uniform integer in [0, n).
+     */
+    int below(int n) {
+        return rng() % n;
+    }
+
+    /**
+     * @brief Shuffles a vector with Fisher-Yates.
+     */
+    template <class T>
+    void shuffle(vector<T>& v) {
+        for (int i = (int)v.size() - 1; i > 0; i--) swap(v[i], v[below(i + 1)]);
+    }
+
+    /**
+     * @brief Samples a near-uniform random Latin square with the Jacobson-Matthews Markov chain.
+     *
+     * The chain walks over the incidence cube M[row][column][symbol] of the square, which
+     * has exactly one 1 on every line, starting from the cyclic square. A move adds +1/-1
+     * around a 2x2x2 subcube; it may leave one entry at -1 (an improper square), which
+     * the next moves resolve. The chain stops at the first proper square after the given
+     * number of moves. Every move costs O(1); the cube takes n^3 bytes.
+     *
+     * @param n The order.
+     * @param moves The number of moves, n^3 is plenty to mix.
+     * @return The square, with symbols 1..n.
+     */
+    vector<vector<int>> latin_square(int n, long moves) {
+        vector<int8_t> M((size_t)n * n * n, 0);
+        // First and second moments, sum of t * M and t^2 * M, of the entries of every line
+        // along rows (indexed by column and symbol), columns and symbols. A line holding
+        // one 1 gives its position, one holding two 1s and the -1 gives both positions.
+        vector<int64_t> sum[3], sq[3];
+        for (int a = 0; a < 3; a++) {
+            sum[a].assign(n * n, 0);
+            sq[a].assign(n * n, 0);
+        }
+        auto at = [&](int x, int y, int z) -> int8_t& { return M[((size_t)x * n + y) * n + z]; };
+        auto add = [&](int x, int y, int z, int d) {
+            at(x, y, z) += d;
+            sum[0][y * n + z] += d * x;
+            sq[0][y * n + z] += d * x * x;
+            sum[1][x * n + z] += d * y;
+            sq[1][x * n + z] += d * y * y;
+            sum[2][x * n + y] += d * z;
+            sq[2][x * n + y] += d * z * z;
+        };
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) add(x, y, (x + y) % n, 1);
+        }
+
+        // Returns the position of a 1 on the line through (x, y, z) along an axis, one of
+        // the two picked at random when improper, i.e. when (x, y, z) is the -1 entry
+        auto pick = [&](int x, int y, int z, int axis, bool improper) -> int {
+            int line = axis == 0 ? y * n + z : axis == 1 ? x * n + z : x * n + y;
+            if (!improper) return sum[axis][line];
+            int c = axis == 0 ? x : axis == 1 ? y : z;
+            int64_t p = sum[axis][line] + c, q = sq[axis][line] + (int64_t)c * c; // a + b, a^2 + b^2
+            int64_t r = llround(sqrt((double)(2 * q - p * p))); // |a - b|
+            return below(2) ? (p - r) / 2 : (p + r) / 2;
+        };
+
+        bool improper = false;
+        int x = 0, y = 0, z = 0; // The -1 entry while improper
+        for (long k = 0; k < moves || improper; k++) {
+            if (!improper) {
+                // Any 0 entry of the cube
+                x = below(n);
+                y = below(n);
+                do z = below(n); while (at(x, y, z) != 0);
+            }
+            int x1 = pick(x, y, z, 0, improper);
+            int y1 = pick(x, y, z, 1, improper);
+            int z1 = pick(x, y, z, 2, improper);
+
+            add(x, y, z, 1);
+            add(x, y1, z1, 1);
+            add(x1, y, z1, 1);
+            add(x1, y1, z, 1);
+            add(x1, y, z, -1);
+            add(x, y1, z, -1);
+            add(x, y, z1, -1);
+            add(x1, y1, z1, -1);
+
+            improper = at(x1, y1, z1) < 0;
+            if (improper) {
+                x = x1;
+                y = y1;
+                z = z1;
+            }
+        }
+
+        vector<vector<int>> square(n, vector<int>(n));
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) square[i][j] = sum[2][i * n + j] + 1;
+        }
+        return square;
+    }
+
+    /**
+     * @brief Quasigroup with holes: empties a random share of the cells of a Latin square.
+     *
+     * The result always has a completion, the square it came from.
+     *
+     * @param square A complete Latin square, emptied in place.
+     * @param holes The share of cells to empty, in [0, 1].
+     */
+    void qwh(vector<vector<int>>& square, double holes) {
+        int n = square.size();
+        vector<int> cells(n * n);
+        for (int k = 0; k < n * n; k++) cells[k] = k;
+        shuffle(cells);
+        long count = (long)(holes * n * n + 0.5);
+        for (long k = 0; k < count; k++) square[cells[k] / n][cells[k] % n] = 0;
+    }
+
+    /**
+     * @brief Quasigroup completion: fills random cells with random symbols that do not
+     * clash with their row and column.
+     *
+     * Every cell is tried once, in random order, until the share of filled cells reaches
+     * 1 - holes; a cell without a consistent symbol stays empty. The result may have no
+     * completion.
+     *
+     * @param n The order.
+     * @param holes The share of cells to leave empty, in [0, 1].
+     */
+    vector<vector<int>> qcp(int n, double holes) {
+        vector<vector<int>> square(n, vector<int>(n, 0));
+        vector<char> row_used(n * (n + 1), 0), col_used(n * (n + 1), 0);
+        vector<int> cells(n * n), free;
+        for (int k = 0; k < n * n; k++) cells[k] = k;
+        shuffle(cells);
+        long target = n * n - (long)(holes * n * n + 0.5), filled = 0;
+        for (int k = 0; k < n * n && filled < target; k++) {
+            int i = cells[k] / n, j = cells[k] % n;
+            free.clear();
+            for (int s = 1; s <= n; s++) {
+                if (!row_used[i * (n + 1) + s] && !col_used[j * (n + 1) + s]) free.push_back(s);
+            }
+            if (free.empty()) continue;
+            int s = free[below(free.size())];
+            square[i][j] = s;
+            row_used[i * (n + 1) + s] = col_used[j * (n + 1) + s] = 1;
+            filled++;
+        }
+        return square;
+    }
+
+private:
+    mt19937_64 rng;
+};
+
+#endif
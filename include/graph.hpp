@@ -0,0 +1,114 @@
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+#include <iostream>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @brief Iterates over the neighbours of a cell without storing them.
+ *
+ * In the constraint graph of a Latin square, the neighbours of a cell are exactly the
+ * other cells of its row followed by the other cells of its column.
+ */
+class Neighbours {
+public:
+    class iterator {
+    public:
+        int x; // Order of the square
+        pair<int, int> v; // Cell whose neighbours are visited
+        int k; // 0 .. x-1 walk the row, x .. 2x-1 walk the column
+
+        iterator(int x, pair<int, int> v, int k) : x(x), v(v), k(k) {
+            skip();
+        }
+
+        pair<int, int> operator*() const {
+            return (k < x) ? make_pair(v.first, k) : make_pair(k - x, v.second);
+        }
+
+        iterator& operator++() {
+            k++;
+            skip();
+            return *this;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return k != other.k;
+        }
+
+    private:
+        /**
+         * @brief Steps over the two positions that refer to the cell itself.
+         */
+        void skip() {
+            if (k == v.second) k++;
+            if (k == x + v.first) k++;
+        }
+    };
+
+    int x;
+    pair<int, int> v;
+
+    Neighbours(int x, pair<int, int> v) : x(x), v(v) {
+        ;
+    }
+
+    iterator begin() const {
+        return iterator(x, v, 0);
+    }
+
+    iterator end() const {
+        return iterator(x, v, 2 * x);
+    }
+};
+
+/**
+ * @brief Represents the constraint graph of a Latin square implicitly.
+ *
+ * Two cells are adjacent iff they share a row or a column, so the graph is fully
+ * described by the order of the square and needs no adjacency storage.
+ */
+class Graph {
+public:
+    int n = 0; // Number of vertices
+    int order = 0; // Side of the square
+
+    /**
+     * @brief Returns the neighbours of a vertex.
+     *
+     * @param v The vertex.
+     */
+    Neighbours neighbours(pair<int, int> v) const {
+        return Neighbours(order, v);
+    }
+
+    /**
+     * @brief Checks if two vertices are joined by an edge.
+     *
+     * @param a The first vertex.
+     * @param b The second vertex.
+     * @return true if a and b are distinct cells in the same row or column.
+     */
+    bool adjacent(pair<int, int> a, pair<int, int> b) const {
+        return a != b && (a.first == b.first || a.second == b.second);
+    }
+
+    /**
+     * @brief Prints the graph's adjacency list.
+     */
+    void print_graph() {
+        for (int i = 0; i < order; i++) {
+            for (int j = 0; j < order; j++) {
+                cout << "(" << i << ", " << j << ")" << ": ";
+                for (auto y: neighbours({i, j})) {
+                    cout << "(" << y.first << ", " << y.second << ")" << " ";
+                }
+                cout << "\r\n"; // New line after each vertex
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef IO_HPP
+#define IO_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include "corpus.hpp"
+
+using namespace std;
+
+/**
+ * @brief Reads the next instance of a text stream.
+ *
+ * An instance is its order followed by order * order symbols in row-major order, 0 for an
+ * empty cell. Tokens are separated by whitespace and '#' starts a comment that runs to the
+ * end of the line.
+ *
+ * @param in The stream to read from.
+ * @param square Receives the partial Latin square.
+ * @return false at the end of the stream or on a malformed instance.
+ */
+bool read_instance(istream& in, vector<vector<int>>& square) {
+    auto next = [&](int& v) {
+        while (in >> ws && in.peek() == '#') {
+            string comment;
+            getline(in, comment);
+        }
+        return bool(in >> v);
+    };
+    int x;
+    if (!next(x) || x <= 0) return false;
+    square.assign(x, vector<int>(x, 0));
+    for (int i = 0; i < x; i++) {
+        for (int j = 0; j < x; j++) {
+            if (!next(square[i][j]) || square[i][j] < 0 || square[i][j] > x) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes an instance in the format read by read_instance().
+ */
+void write_instance(ostream& out, const vector<vector<int>>& square) {
+    out << square.size() << "\n";
+    for (auto& row : square) {
+        for (size_t j = 0; j < row.size(); j++) out << row[j] << (j + 1 < row.size() ? " " : "\n");
+    }
+}
+
+/**
+ * @brief Solves a binary corpus, see corpus.hpp, for run_batch().
+ *
+ * Workers claim consecutive index ranges of the mapped corpus and decode each instance
+ * straight from the mapping into a square they reuse, so nothing is parsed. An instance
+ * holding a symbol above its order is reported and skipped.
+ */
+long run_corpus(const string& path, int workers, function<void(long, const vector<vector<int>>&, ostream&)> solve) {
+    corpus::Reader C;
+    if (!C.open(path)) {
+        cout << "Cannot map " << path << ", or it is truncated or corrupt\n";
+        exit(1);
+    }
+    const long total = C.size();
+    const long chunk = max(1L, min(64L, total / (8L * workers))); // Instances claimed at once
+
+    mutex lock;
+    condition_variable finished;
+    map<long, string> results;
+    atomic<long> claimed(0);
+
+    vector<thread> pool;
+    for (int w = 0; w < workers; w++) {
+        pool.emplace_back([&]() {
+            vector<vector<int>> square;
+            while (true) {
+                long first = claimed.fetch_add(chunk);
+                if (first >= total) return;
+                for (long k = first; k < min(first + chunk, total); k++) {
+                    ostringstream out;
+                    if (C[k].square(square)) solve(k, square, out);
+                    else out << "Malformed instance, skipped\n";
+                    lock_guard<mutex> guard(lock);
+                    results[k] = out.str();
+                    finished.notify_all();
+                }
+            }
+        });
+    }
+
+    for (long k = 0; k < total; k++) {
+        string text;
+        {
+            unique_lock<mutex> guard(lock);
+            finished.wait(guard, [&]() { return results.count(k); });
+            text = move(results[k]);
+            results.erase(k);
+        }
+        cout << "Instance " << k << "\n" << text << flush;
+    }
+
+    for (auto& t : pool) t.join();
+    return total;
+}
+
+/**
+ * @brief Solves a stream of instances as a pipeline and writes the results in input order.
+ *
+ * One thread parses instances into a bounded queue, a pool of workers solves them, and
+ * the calling thread writes every result as soon as all earlier ones are written. Each
+ * result is printed after an "Instance <k>" line, counting from 0.
+ *
+ * @param path The instance file, or "-" for stdin. Binary corpora are detected by their
+ *             magic and memory-mapped instead of parsed.
+ * @param workers The number of solver threads. Targets that parallelise a single
+ *                instance themselves should use 1.
+ * @param solve Solves one instance, given its index and partial square, writing its output
+ *              to the given stream.
+ * @return The number of instances solved.
+ */
+long run_batch(const string& path, int workers, function<void(long, const vector<vector<int>>&, ostream&)> solve) {
+    workers = max(workers, 1);
+    if (path != "-" && corpus::is_corpus(path)) return run_corpus(path, workers, solve);
+
+    ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            cout << "Cannot open " << path << "\n";
+            exit(1);
+        }
+    }
+    istream& in = (path == "-") ? cin : file;
+    const size_t capacity = 4 * workers; // Parsed instances waiting for a worker
+
+    mutex lock;
+    condition_variable parsed, taken, finished;
+    deque<pair<long, vector<vector<int>>>> pending;
+    map<long, string> results;
+    bool eof = false;
+    long total = -1;
+
+    thread parser([&]() {
+        vector<vector<int>> square;
+        long count = 0;
+        while (read_instance(in, square)) {
+            unique_lock<mutex> guard(lock);
+            taken.wait(guard, [&]() { return pending.size() < capacity; });
+            pending.push_back({count++, move(square)});
+            parsed.notify_one();
+        }
+        if (!in.eof()) cerr << "Malformed instance " << count << " in " << path << ", stopping\n";
+        lock_guard<mutex> guard(lock);
+        eof = true;
+        total = count;
+        parsed.notify_all();
+        finished.notify_all();
+    });
+
+    vector<thread> pool;
+    for (int w = 0; w < workers; w++) {
+        pool.emplace_back([&]() {
+            while (true) {
+                pair<long, vector<vector<int>>> job;
+                {
+                    unique_lock<mutex> guard(lock);
+                    parsed.wait(guard, [&]() { return !pending.empty() || eof; });
+                    if (pending.empty()) return;
+                    job = move(pending.front());
+                    pending.pop_front();
+                    taken.notify_one();
+                }
+                ostringstream out;
+                solve(job.first, job.second, out);
+                lock_guard<mutex> guard(lock);
+                results[job.first] = out.str();
+                finished.notify_all();
+            }
+        });
+    }
+
+    // Write the results in input order
+    for (long k = 0;; k++) {
+        string text;
+        {
+            unique_lock<mutex> guard(lock);
+            finished.wait(guard, [&]() { return results.count(k) || (total >= 0 && k >= total); });
+            if (!results.count(k)) break;
+            text = move(results[k]);
+            results.erase(k);
+        }
+        cout << "Instance " << k << "\n" << text << flush;
+    }
+
+    parser.join();
+    for (auto& t : pool) t.join();
+    return total;
+}
+
+#endif
@@ -9,58 +9,30 @@
 #include <chrono>
 #include <ctime>
 #include <algorithm>
+#include "domain.hpp"
+#include "graph.hpp"
+#include "conflicts.hpp"
+#include "zobrist.hpp"
+#include "propagate.hpp"
+#include "alldiff.hpp"
+#include "seed.hpp"
+#include "stats.hpp"
+#include <cassert>
 
 using namespace std;
 
 class Compare;
 
 /**
- * @brief Searches for an element in a vector.
+ * @brief Compact search node: a parent reference plus the single move that produced it.
  *
- * @tparam T Type of elements in the vector.
- * @param v The vector to search in.
- * @param e The element to find.
- * @return true if the element is found, false otherwise.
+ * A node takes 8 bytes. Full states are only rebuilt, with rebuild(), when a node is
+ * expanded.
  */
-template <typename T>
-bool find(vector<T>& v, T e) {
-    for (auto& It: v) {
-        if (It == e) return true; // Check if the element exists
-    }
-    return false; // Element not found
-}
-
-/**
- * @brief Represents a graph using an adjacency list.
- */
-class Graph {
-public:
-    int n; // Number of vertices
-    map<pair<int, int>, vector<pair<int, int>>> adj_list; // Adjacency list
-
-    /**
-     * @brief Adds an edge between two vertices.
-     *
-     * @param n1 The first vertex.
-     * @param n2 The second vertex.
-     */
-    void add_edge(pair<int, int> n1, pair<int, int> n2) {
-        adj_list[n1].push_back(n2); // Add n2 to n1's adjacency list
-        adj_list[n2].push_back(n1); // Add n1 to n2's adjacency list
-    }
-
-    /**
-     * @brief Prints the graph's adjacency list.
-     */
-    void print_graph() {
-        for (auto& x: adj_list) {
-            cout << "(" << x.first.first << ", " << x.first.second << ")" << ": ";
-            for (auto y: x.second) {
-                cout << "(" << y.first << ", " << y.second << ")" << " ";
-            }
-            cout << "\r\n"; // New line after each vertex
-        }
-    }
+struct Node {
+    int parent; // Index of the parent node, -1 for the root
+    uint8_t i, j; // Cell that was moved
+    uint8_t from, to; // Old and new color of the cell
 };
 
 /**
@@ -69,8 +41,12 @@ public:
 class LSC : public Graph {
 public:
     vector<vector<int>> square; // Latin square representation
-    map<pair<int, int>, set<int>> D; // Domain set for each cell
+    Domain D; // Filtered domain of every free cell, fixed after construction
     map<int, set<pair<int, int>>> V; // Color classes
+    Conflicts C; // Row/column symbol counters and running conflict total
+    uint64_t hash = 0; // Zobrist hash of the square
+    vector<pair<int, int>> Cand_set; // Free cells, the only ones a move may recolor
+    string error; // Why the instance was rejected, empty if it is usable
 
     /**
      * @brief Default constructor.
@@ -83,25 +59,28 @@ public:
      * @brief Constructor for initializing LSC with a partial Latin square.
      *
      * @param partial The initial partial Latin square.
+     * @param seed Seeds the random coloring of the free cells.
      */
-    LSC(vector<vector<int>> partial) {
+    LSC(vector<vector<int>> partial, unsigned seed) {
+        STATS_PHASE(PREPROCESS);
         int x = partial.size(); // Size of the square
-        vector<pair<int, int>> Cand_set; // Candidate cells to color
         n = x * x; // Total number of cells
         square = partial; // Set the square
+        if (x > MAX_ORDER) {
+            error = "Orders above " + to_string(MAX_ORDER) + " are not supported\n";
+            return;
+        }
+        D = Domain(x, Domain::range(1, x)); // Initialize domain set for empty cells
 
-        // Build adjacency list and initialize candidate set
+        order = x; // The constraint graph is implied by the order
+
+        // Initialize candidate set
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
-                for (int k = j + 1; k < x; k++) {
-                    add_edge({i, j}, {i, k}); // Add horizontal edges
-                    add_edge({j, i}, {k, i}); // Add vertical edges
-                }
                 if (square[i][j] == 0) {
                     Cand_set.push_back({i, j}); // Add empty cells to candidate set
-                    for (int k = 1; k <= x; k++) {
-                        D[{i, j}].insert(k); // Initialize domain set for empty cells
-                    }
+                } else {
+                    D.clear({i, j}); // Filled cells have no domain
                 }
             }
         }
@@ -110,56 +89,46 @@ public:
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
                 if (square[i][j] != 0) {
-                    for (auto It : adj_list[{i, j}]) {
-                        D[It].erase(square[i][j]); // Remove filled color from adjacent cells
-                    }
+                    D.place({i, j}, square[i][j]); // Remove filled color from adjacent cells
                     V[square[i][j]].insert({i, j}); // Assign the filled color
                 }
             }
         }
 
-        // Reduce domain set using smart solving
-        bool isReducible = true;
-        while (isReducible) {
-            isReducible = false;
-            for (int i = 0; i < x; i++) {
-                for (int j = 0; j < x; j++) {
-                    // Only one possible color can be assigned
-                    if (D[{i, j}].size() == 1) {
-                        int color = *D[{i, j}].begin(); // Get the only color
-                        V[color].insert({i, j}); // Assign color to the cell
-                        D[{i, j}].erase(color); // Remove color from the domain
-                        square[i][j] = color; // Update the square
-                        for (auto It : adj_list[{i, j}]) {
-                            D[It].erase(color); // Update adjacent cells' domains
-                        }
-                        isReducible = true; // Continue reducing
-                        pair<int, int> n1 = {i, j};
-                        // Remove the cell from the candidate set
-                        Cand_set.erase(remove(Cand_set.begin(), Cand_set.end(), n1), Cand_set.end());
-                    }
-                }
-            }
+        // Reduce domain set with singles and all-different filtering
+        Propagator P(x);
+        AllDiff A(x);
+        vector<pair<int, int>> fixed;
+        if (!propagate(D, square, P, A, fixed)) {
+            error = "Given Partial Latin Square cannot be solved\n";
+            return;
         }
+        for (auto& v : fixed) {
+            V[square[v.first][v.second]].insert(v); // Assign the forced color
+        }
+        // Remove the fixed cells from the candidate set
+        Cand_set.erase(remove_if(Cand_set.begin(), Cand_set.end(), [&](const pair<int, int>& v) {
+            return square[v.first][v.second] != 0;
+        }), Cand_set.end());
 
         // Randomly assign colors to remaining candidates
         // shuffle(Cand_set.begin(), Cand_set.end(), default_random_engine(time(0)));
 
-        srand(time(0));
+        mt19937 rng(seed); // Each instance has its own engine, workers run concurrently
         for (auto& It : Cand_set) {
-            if (D[It].size() != 0) {
-                int r = rand() % D[It].size();
-                auto Iter = D[It].begin();
-                advance(Iter, r); // Get a random color from the domain
-                int color = *Iter;
+            if (D.size(It) != 0) {
+                int r = rng() % D.size(It);
+                int color = D.kth(It, r); // Get a random color from the domain
                 V[color].insert(It); // Assign color to the cell
-                D[It].erase(Iter); // Remove the color from the domain
                 square[It.first][It.second] = color; // Update the square
             } else {
-                cout << "Given Partial Latin Square cannot be solved\n";
-                exit(1); // Exit if no colors are available
+                error = "Given Partial Latin Square cannot be solved\n"; // No colors are available
+                return;
             }
         }
+
+        C = Conflicts(square); // Count the conflicts of the initial coloring
+        hash = zobrist(square);
     }
 
     /**
@@ -170,17 +139,36 @@ public:
      * @param color2 The color to move to.
      */
     void Move(pair<int, int> v, int color1, int color2) {
+        STATS_COUNT(MOVES);
         V[color1].erase(v); // Remove the vertex from the old color
         V[color2].insert(v); // Add the vertex to the new color
         square[v.first][v.second] = color2; // Update the square
+        C.move(v, color1, color2); // Update the conflict counters
+        hash ^= zobrist(v, color1) ^ zobrist(v, color2); // Update the state hash
     }
 
     /**
      * @brief Computes the conflict level (CL) of the current state.
      *
+     * Reads the running total kept by Move(). Building with -DLSC_DEBUG checks it
+     * against a full recount.
+     *
      * @return The number of color conflicts.
      */
     int CL() {
+        STATS_COUNT(CL_CALLS);
+#ifdef LSC_DEBUG
+        assert(C.total == recount());
+#endif
+        return C.total;
+    }
+
+    /**
+     * @brief Recounts the conflict level by comparing every pair inside each color class.
+     *
+     * @return The number of color conflicts.
+     */
+    int recount() {
         int res = 0;
         for (auto& color_set : V) {
             auto It = color_set.second.begin();
@@ -188,7 +176,7 @@ public:
                 auto next_It = It;
                 next_It++;
                 while (next_It != color_set.second.end()) {
-                    if (find(adj_list[*It], *next_It)) {
+                    if (adjacent(*It, *next_It)) {
                         res++; // Increment conflict count if adjacent
                     }
                     next_It++;
@@ -202,13 +190,13 @@ public:
     /**
      * @brief Prints the current state of the Latin square.
      */
-    void printSquare() {
+    void printSquare(ostream& out = cout) const {
         int x = square.size();
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
-                cout << square[i][j] << " "; // Print each element
+                out << square[i][j] << " "; // Print each element
             }
-            cout << "\n"; // New line after each row
+            out << "\n"; // New line after each row
         }
     }
 
@@ -222,9 +210,9 @@ public:
     }
 
     // Function declarations for generating moves
-    void MoveGen(queue<LSC>& Q, map<vector<vector<int>>, int>& visited);
-    void MoveGen(stack<LSC>& Q, map<vector<vector<int>>, int>& visited);
-    void MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, map<vector<vector<int>>, int>& visited);
+    void MoveGen(int self, vector<Node>& nodes, queue<int>& Q, HashSet& visited);
+    void MoveGen(int self, vector<Node>& nodes, stack<int>& Q, HashSet& visited);
+    void MoveGen(int self, vector<Node>& nodes, priority_queue<pair<int, int>, vector<pair<int, int>>, Compare>& Q, HashSet& visited);
 };
 
 /**
@@ -233,106 +221,146 @@ public:
 class Compare {
 public:
     /**
-     * @brief Overloads the comparison operator to sort by conflict level.
+     * @brief Overloads the comparison operator to sort by conflict reduction.
      *
-     * @param a First LSC instance with its conflict level.
-     * @param b Second LSC instance with its conflict level.
-     * @return true if the conflict level of a is less than that of b.
+     * @param a First node index with its conflict reduction.
+     * @param b Second node index with its conflict reduction.
+     * @return true if the conflict reduction of a is less than that of b.
      */
-    bool operator() (const pair<LSC, int>& a, const pair<LSC, int>& b) {
-        return (a.second < b.second); // Compare based on conflict level
+    bool operator() (const pair<int, int>& a, const pair<int, int>& b) {
+        return (a.second < b.second); // Compare based on conflict reduction
     }
 };
 
 /**
- * @brief Generates moves and adds new states to the queue.
+ * @brief Returns the number of moves between the root and a search node.
+ */
+int depth(const vector<Node>& nodes, int id) {
+    int d = 0;
+    for (int k = id; k > 0; k = nodes[k].parent) d++;
+    return d;
+}
+
+/**
+ * @brief Rebuilds the full state of a search node from the state of another node.
+ *
+ * Moves of curr are undone up to the common ancestor of the two nodes, then the moves
+ * down to the requested node are replayed, so the state is never copied. A child of
+ * curr therefore costs a single move.
  *
- * @param Q The queue to add generated states.
- * @param visited Map tracking visited states.
+ * @param root The state of node 0.
+ * @param nodes The node arena.
+ * @param id The node to rebuild.
+ * @param curr The state being rebuilt, holding the state of node curr_id on entry.
+ * @param curr_id The node held in curr, -1 if none. Set to id on return.
  */
-void LSC::MoveGen(queue<LSC>& Q, map<vector<vector<int>>, int>& visited) {
-    vector<int> colors; // List of available colors
-    for (int i = 1; i <= square.size(); i++) {
-        colors.push_back(i);
+void rebuild(const LSC& root, const vector<Node>& nodes, int id, LSC& curr, int& curr_id) {
+    if (curr_id < 0) {
+        curr = root;
+        curr_id = 0;
     }
-    for (auto& color_set : V) {
-        for (auto& cell : color_set.second) {
-            for (auto& color_next : colors) {
-                if (color_next != color_set.first) { // Avoid using the same color
-                    LSC neigh; // Create a neighbor LSC
-                    neigh.n = n;
-                    neigh.adj_list = adj_list;
-                    neigh.square = square;
-                    neigh.V = V;
-                    neigh.D = D;
-                    neigh.Move(cell, color_set.first, color_next); // Perform the move
-                    if (visited[neigh.square] != 1) {
-                        Q.push(neigh); // Add to the queue if not visited
-                    }
-                }
+    int a = curr_id, b = id;
+    int da = depth(nodes, a), db = depth(nodes, b);
+    vector<int> path; // Nodes from b up to the common ancestor
+    while (da > db) {
+        const Node& node = nodes[a];
+        curr.Move({node.i, node.j}, node.to, node.from); // Undo the move of a
+        a = node.parent;
+        da--;
+    }
+    while (db > da) {
+        path.push_back(b);
+        b = nodes[b].parent;
+        db--;
+    }
+    while (a != b) {
+        const Node& node = nodes[a];
+        curr.Move({node.i, node.j}, node.to, node.from);
+        a = node.parent;
+        path.push_back(b);
+        b = nodes[b].parent;
+    }
+    for (auto It = path.rbegin(); It != path.rend(); It++) {
+        const Node& node = nodes[*It];
+        curr.Move({node.i, node.j}, node.from, node.to);
+    }
+    curr_id = id;
+}
+
+/**
+ * @brief Generates moves and adds new nodes to the queue.
+ *
+ * @param self Index of this state in the node arena.
+ * @param nodes The node arena.
+ * @param Q The queue to add generated nodes.
+ * @param visited Fingerprints of states generated so far.
+ */
+void LSC::MoveGen(int self, vector<Node>& nodes, queue<int>& Q, HashSet& visited) {
+    int x = square.size();
+    for (auto& cell : Cand_set) {
+        int color = square[cell.first][cell.second];
+        for (int color_next = 1; color_next <= x; color_next++) {
+            if (color_next == color) continue; // Avoid using the same color
+            STATS_COUNT(NEIGHBOURS);
+            uint64_t h = hash ^ zobrist(cell, color) ^ zobrist(cell, color_next);
+            if (!visited.insert(h)) {
+                STATS_COUNT(VISITED_REJECTED);
+                continue; // Skip states that were already generated
             }
+            nodes.push_back({self, (uint8_t)cell.first, (uint8_t)cell.second, (uint8_t)color, (uint8_t)color_next});
+            Q.push(nodes.size() - 1); // Add to the queue
         }
     }
 }
 
 /**
- * @brief Generates moves and adds new states to the stack.
+ * @brief Generates moves and adds new nodes to the stack.
  *
- * @param Q The stack to add generated states.
- * @param visited Map tracking visited states.
+ * @param self Index of this state in the node arena.
+ * @param nodes The node arena.
+ * @param Q The stack to add generated nodes.
+ * @param visited Fingerprints of states generated so far.
  */
-void LSC::MoveGen(stack<LSC>& Q, map<vector<vector<int>>, int>& visited) {
-    vector<int> colors; // List of available colors
-    for (int i = 1; i <= square.size(); i++) {
-        colors.push_back(i);
-    }
-    for (auto& color_set : V) {
-        for (auto& cell : color_set.second) {
-            for (auto& color_next : colors) {
-                if (color_next != color_set.first) { // Avoid using the same color
-                    LSC neigh; // Create a neighbor LSC
-                    neigh.n = n;
-                    neigh.adj_list = adj_list;
-                    neigh.square = square;
-                    neigh.V = V;
-                    neigh.D = D;
-                    neigh.Move(cell, color_set.first, color_next); // Perform the move
-                    if (visited[neigh.square] != 1) {
-                        Q.push(neigh); // Add to the stack if not visited
-                    }
-                }
+void LSC::MoveGen(int self, vector<Node>& nodes, stack<int>& Q, HashSet& visited) {
+    int x = square.size();
+    for (auto& cell : Cand_set) {
+        int color = square[cell.first][cell.second];
+        for (int color_next = 1; color_next <= x; color_next++) {
+            if (color_next == color) continue; // Avoid using the same color
+            STATS_COUNT(NEIGHBOURS);
+            uint64_t h = hash ^ zobrist(cell, color) ^ zobrist(cell, color_next);
+            if (!visited.insert(h)) {
+                STATS_COUNT(VISITED_REJECTED);
+                continue; // Skip states that were already generated
             }
+            nodes.push_back({self, (uint8_t)cell.first, (uint8_t)cell.second, (uint8_t)color, (uint8_t)color_next});
+            Q.push(nodes.size() - 1); // Add to the stack
         }
     }
 }
 
 /**
- * @brief Generates moves and adds new states to the priority queue.
+ * @brief Generates moves and adds new nodes to the priority queue.
  *
- * @param Q The priority queue to add generated states.
- * @param visited Map tracking visited states.
+ * @param self Index of this state in the node arena.
+ * @param nodes The node arena.
+ * @param Q The priority queue to add generated nodes.
+ * @param visited Fingerprints of states generated so far.
  */
-void LSC::MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, map<vector<vector<int>>, int>& visited) {
-    vector<int> colors; // List of available colors
-    for (int i = 1; i <= square.size(); i++) {
-        colors.push_back(i);
-    }
-    for (auto& color_set : V) {
-        for (auto& cell : color_set.second) {
-            for (auto& color_next : colors) {
-                if (color_next != color_set.first) { // Avoid using the same color
-                    LSC neigh; // Create a neighbor LSC
-                    neigh.n = n;
-                    neigh.adj_list = adj_list;
-                    neigh.square = square;
-                    neigh.V = V;
-                    neigh.D = D;
-                    neigh.Move(cell, color_set.first, color_next); // Perform the move
-                    if (visited[neigh.square] != 1) {
-                        Q.push({neigh, CL() - neigh.CL()}); // Add to the priority queue with priority based on conflict reduction
-                    }
-                }
+void LSC::MoveGen(int self, vector<Node>& nodes, priority_queue<pair<int, int>, vector<pair<int, int>>, Compare>& Q, HashSet& visited) {
+    int x = square.size();
+    for (auto& cell : Cand_set) {
+        int color = square[cell.first][cell.second];
+        for (int color_next = 1; color_next <= x; color_next++) {
+            if (color_next == color) continue; // Avoid using the same color
+            STATS_COUNT(NEIGHBOURS);
+            uint64_t h = hash ^ zobrist(cell, color) ^ zobrist(cell, color_next);
+            if (!visited.insert(h)) {
+                STATS_COUNT(VISITED_REJECTED);
+                continue; // Skip states that were already generated
             }
+            nodes.push_back({self, (uint8_t)cell.first, (uint8_t)cell.second, (uint8_t)color, (uint8_t)color_next});
+            Q.push({(int)nodes.size() - 1, -(C.total + C.delta(cell, color, color_next))}); // Fewer conflicts first, i.e. the largest reduction from the root
         }
     }
 }
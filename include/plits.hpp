@@ -10,72 +10,64 @@
 #include <ctime>
 #include <algorithm>
 #include <list>
+#include "domain.hpp"
+#include "graph.hpp"
+#include "conflicts.hpp"
+#include "zobrist.hpp"
+#include "propagate.hpp"
+#include "seed.hpp"
+#include "stats.hpp"
+#include <cassert>
 
 using namespace std;
 
 class Compare;
 
 /**
- * @brief Searches for an element in a vector.
+ * @brief Attribute-based tabu memory for PLITS.
  *
- * @tparam T Type of elements in the vector.
- * @param v The vector to search in.
- * @param e The element to find.
- * @return true if the element is found, false otherwise.
+ * For every (cell, color) pair it stores the iteration until which moving the cell to
+ * that color is forbidden, so checks and updates are O(1) and the footprint stays at
+ * n^2 (n + 1) integers however long the search runs.
  */
-template <typename T>
-bool find(vector<T>& v, T e) {
-    for (auto& It: v) {
-        if (It == e) return true; // Check if the element exists
+class TabuList {
+public:
+    int x = 0; // Order of the square
+    vector<int> until; // until[(i * x + j) * (x + 1) + c]: first iteration the move is allowed again
+
+    /**
+     * @brief Default constructor.
+     */
+    TabuList() {
+        ;
     }
-    return false; // Element not found
-}
 
-/**
- * @brief Represents a graph using an adjacency list.
- */
-class Graph {
-public:
-    int n; // Number of vertices
-    map<pair<int, int>, vector<pair<int, int>>> adj_list; // Adjacency list
+    /**
+     * @brief Creates an empty tabu list for a square of the given order.
+     */
+    TabuList(int order) : x(order), until(order * order * (order + 1), 0) {
+        ;
+    }
 
     /**
-     * @brief Adds an edge between two vertices.
-     *
-     * @param n1 The first vertex.
-     * @param n2 The second vertex.
+     * @brief Checks if moving cell v to color c is tabu at iteration iter.
      */
-    void add_edge(pair<int, int> n1, pair<int, int> n2) {
-        adj_list[n1].push_back(n2); // Add n2 to n1's adjacency list
-        adj_list[n2].push_back(n1); // Add n1 to n2's adjacency list
+    bool is_tabu(pair<int, int> v, int c, int iter) const {
+        return until[(v.first * x + v.second) * (x + 1) + c] > iter;
     }
 
     /**
-     * @brief Removes a vertex and its associated edges from the graph.
-     *
-     * @param i The vertex to remove.
+     * @brief Forbids moving cell v to color c until iteration expiry.
      */
-    void remove_vertex(pair<int, int> i) {
-        n--;
-        adj_list.erase(i); // Remove the vertex
-        for (auto& x: adj_list) {
-            for (int j = 0; j < x.second.size(); j++) {
-                if (x.second[j] == i) x.second.erase(x.second.begin() + j);
-            }
-        }
+    void add(pair<int, int> v, int c, int expiry) {
+        until[(v.first * x + v.second) * (x + 1) + c] = expiry;
     }
 
     /**
-     * @brief Prints the graph's adjacency list.
+     * @brief Lifts every tabu.
      */
-    void print_graph() {
-        for (auto& x: adj_list) {
-            cout << "(" << x.first.first << ", " << x.first.second << ")" << ": ";
-            for (auto y: x.second) {
-                cout << "(" << y.first << ", " << y.second << ")" << " ";
-            }
-            cout << "\r\n"; // New line after each vertex
-        }
+    void clear() {
+        fill(until.begin(), until.end(), 0);
     }
 };
 
@@ -85,10 +77,13 @@ public:
 class LSC : public Graph {
 public:
     vector<vector<int>> square; // Latin square representation
-    map<pair<int, int>, set<int>> D; // Domain set for each cell
+    Domain D; // Domain set for each cell (symbol 0 leaves the cell empty)
     map<int, set<pair<int, int>>> V; // Color classes
+    Conflicts C; // Row/column symbol counters and running conflict total
+    uint64_t hash = 0; // Zobrist hash of the square
     int l = 0; // Number of cells impossible to fill (D(u) = {0})
     vector<pair<int, int>> Cand_set;
+    string error; // Why the instance was rejected, empty if it is usable
 
     /**
      * @brief Default constructor.
@@ -114,18 +109,25 @@ public:
 
     /**
      * @brief Initializes the color assignment for empty cells.
+     *
+     * The cells are colored in a random order, but Cand_set keeps its order so that it is
+     * the same in every member of a population.
+     *
+     * @param seed Seeds the order and the colors.
      */
-    void init() {
-        shuffle(Cand_set.begin(), Cand_set.end(), default_random_engine(time(0)));
-        for (auto& It: Cand_set) {
-            if (D[It].size() != 0) {
-                int r = rand() % D[It].size();
-                auto Iter = D[It].begin();
-                advance(Iter, r);
-                int color = *Iter;
+    void init(unsigned seed) {
+        mt19937 rng(seed);
+        vector<pair<int, int>> cells = Cand_set;
+        shuffle(cells.begin(), cells.end(), rng);
+        for (auto& It: cells) {
+            if (D.size(It) != 0) {
+                int r = rng() % D.size(It);
+                int color = D.kth(It, r);
                 V[color].insert(It);
-                D[It].erase(Iter);
+                D.erase(It, color);
                 square[It.first][It.second] = color;
+                C.add(It, color);
+                hash ^= zobrist(It, color);
             }
         }
     }
@@ -134,23 +136,26 @@ public:
      * @brief Generates a population of LSC instances based on the current state.
      *
      * @param pop_size The size of the population to generate.
+     * @param seed Seeds the population; member i is always drawn from the same engine.
      * @return A vector containing the generated LSC instances.
      */
-    vector<LSC> gen_population(int pop_size) {
-        vector<LSC> res; // Resulting population
+    vector<LSC> gen_population(int pop_size, unsigned seed) {
+        STATS_PHASE(POPULATION);
+        vector<LSC> res(pop_size); // Resulting population
         #pragma omp parallel for shared(res)
         for (int i = 0; i < pop_size; i++) {
             LSC temp;
             temp.square = square; // Copy current state
             temp.D = D;
+            temp.C = C;
+            temp.hash = hash;
             temp.V = V;
             temp.n = n;
             temp.l = l;
             temp.Cand_set = Cand_set;
-            temp.adj_list = adj_list;
-            temp.init(); // Initialize the new instance
-            #pragma omp critical
-            res.push_back(temp); // Add to the population
+            temp.order = order;
+            temp.init(seed ^ (i * 0x9E3779B9u)); // Initialize the new instance
+            res[i] = temp; // Add to the population
         }
         return res;
     }
@@ -163,11 +168,13 @@ public:
     void operator=(const LSC& L) {
         square = L.square;
         D = L.D;
+        C = L.C;
+        hash = L.hash;
         V = L.V;
         n = L.n;
         l = L.l;
         Cand_set = L.Cand_set;
-        adj_list = L.adj_list;
+        order = L.order;
     }
 
     /**
@@ -176,22 +183,25 @@ public:
      * @param partial The initial partial Latin square.
      */
     LSC(vector<vector<int>> partial) {
+        STATS_PHASE(PREPROCESS);
         int x = partial.size();
         n = x * x;
         square = partial;
+        if (x > MAX_ORDER) {
+            error = "Orders above " + to_string(MAX_ORDER) + " are not supported\n";
+            return;
+        }
+        D = Domain(x, Domain::range(0, x)); // Initialize domain set for empty cells
+
+        order = x; // The constraint graph is implied by the order
 
-        // Build adjacency list and initialize candidate set
+        // Initialize candidate set
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
-                for (int k = j + 1; k < x; k++) {
-                    add_edge({i, j}, {i, k});
-                    add_edge({j, i}, {k, i});
-                }
                 if (square[i][j] == 0) {
                     Cand_set.push_back({i, j}); // Add empty cells to candidate set
-                    for (int k = 0; k <= x; k++) {
-                        D[{i, j}].insert(k); // Initialize domain set for empty cells
-                    }
+                } else {
+                    D.clear({i, j}); // Filled cells have no domain
                 }
             }
         }
@@ -200,39 +210,37 @@ public:
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
                 if (square[i][j] != 0) {
-                    for (auto It : adj_list[{i, j}]) {
-                        D[It].erase(square[i][j]); // Remove filled color from adjacent cells
-                    }
+                    D.place({i, j}, square[i][j]); // Remove filled color from adjacent cells
                     V[square[i][j]].insert({i, j}); // Assign the filled color
                 }
             }
         }
 
-        // Reduce domain set using smart solving
-        bool isReducible = true;
-        while (isReducible) {
-            isReducible = false;
-            for (int i = 0; i < x; i++) {
-                for (int j = 0; j < x; j++) {
-                    // Only one possible color can be assigned
-                    if (D[{i, j}].size() == 1) {
-                        isReducible = true;
-                        int color = *D[{i, j}].begin(); // Get the only color
-                        V[color].insert({i, j}); // Assign color to the cell
-                        square[i][j] = color; // Update the square
-                        if (color == 0) l++; // Count empty cells
-                        else {
-                            for (auto It : adj_list[{i, j}]) {
-                                D[It].erase(color); // Update adjacent cells' domains
-                            }
-                        }
-                        pair<int, int> n1 = {i, j};
-                        Cand_set.erase(remove(Cand_set.begin(), Cand_set.end(), n1), Cand_set.end()); // Remove from candidates
-                        remove_vertex({i, j}); // Remove the vertex
-                    }
-                }
+        // Reduce domain set with naked and hidden singles. A contradiction only stops the
+        // propagation early; the cells it leaves without a symbol are handled below.
+        Propagator P(x);
+        vector<pair<int, int>> fixed;
+        P.run(D, square, fixed);
+        for (auto& v : fixed) {
+            V[square[v.first][v.second]].insert(v); // Assign the forced color
+            n--; // Remove the vertex
+        }
+
+        // Cells with no symbol left stay empty for good
+        for (auto& v : Cand_set) {
+            if (square[v.first][v.second] == 0 && D.size(v) == 1) {
+                V[0].insert(v);
+                D.clear(v);
+                l++; // Count empty cells
+                n--; // Remove the vertex
             }
         }
+        Cand_set.erase(remove_if(Cand_set.begin(), Cand_set.end(), [&](const pair<int, int>& v) {
+            return D.size(v) == 0;
+        }), Cand_set.end());
+
+        C = Conflicts(square); // Count the conflicts of the reduced square
+        hash = zobrist(square);
     }
 
     /**
@@ -243,17 +251,36 @@ public:
      * @param color2 The color to move to.
      */
     void Move(pair<int, int> v, int color1, int color2) {
+        STATS_COUNT(MOVES);
         V[color1].erase(v);
         V[color2].insert(v);
         square[v.first][v.second] = color2;
+        C.move(v, color1, color2);
+        hash ^= zobrist(v, color1) ^ zobrist(v, color2);
     }
 
     /**
      * @brief Calculates the number of conflicts in the current coloring.
      *
+     * Reads the running total kept by Move(). Building with -DLSC_DEBUG checks it
+     * against a full recount.
+     *
      * @return The total number of conflicts.
      */
     int CL() {
+        STATS_COUNT(CL_CALLS);
+#ifdef LSC_DEBUG
+        assert(C.total == recount());
+#endif
+        return C.total;
+    }
+
+    /**
+     * @brief Recounts the conflicts by comparing every pair inside each color class.
+     *
+     * @return The total number of conflicts.
+     */
+    int recount() {
         int res = 0;
         for (auto& color_set: V) {
             if (color_set.first == 0) continue; // Skip empty color
@@ -262,7 +289,7 @@ public:
                 auto next_It = It;
                 next_It++;
                 while (next_It != color_set.second.end()) {
-                    if (find(adj_list[*It], *next_It)) {
+                    if (adjacent(*It, *next_It)) {
                         res++; // Count conflicts
                     }
                     next_It++;
@@ -292,17 +319,35 @@ public:
         return f() + phi * CL();
     }
 
+    /**
+     * @brief Calculates the change in fitness if a vertex were moved to another color.
+     *
+     * The move-gain table of Jin & Hao is implicit here: the conflicts a cell would have
+     * with color c are the row and column counters of c, so every gain is O(1).
+     *
+     * @param v The vertex to move.
+     * @param color The color to move to.
+     * @param phi A weight parameter for conflict penalty.
+     * @return F(phi) after the move minus F(phi) before it.
+     */
+    float gain(pair<int, int> v, int color, float phi) {
+        int curr = square[v.first][v.second];
+        return ((color == 0) - (curr == 0)) + phi * C.delta(v, curr, color);
+    }
+
     /**
      * @brief Prints the domain set for each cell.
      */
     void print_domains() {
         int x = square.size();
-        for (auto& It: adj_list) {
-            cout << "(" << It.first.first << "," << It.first.second << "): ";
-            for (auto It2: D[It.first]) {
-                cout << It2 << " ";
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) {
+                cout << "(" << i << "," << j << "): ";
+                for (int k = 0; k <= x; k++) {
+                    if (D.contains({i, j}, k)) cout << k << " ";
+                }
+                cout << "\n";
             }
-            cout << "\n";
         }
     }
 
@@ -322,13 +367,13 @@ public:
     /**
      * @brief Prints the current state of the Latin square.
      */
-    void printSquare() {
+    void printSquare(ostream& out = cout) const {
         int x = square.size();
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
-                cout << square[i][j] << " ";
+                out << square[i][j] << " ";
             }
-            cout << "\n";
+            out << "\n";
         }
     }
 
@@ -352,8 +397,8 @@ public:
         return res;
     }
 
-    void MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, map<vector<vector<int>>, int>& visited);
-    void MoveGen(int phi, int tt, priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, map<vector<vector<int>>, int>& tabu);
+    void MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, HashSet& visited);
+    bool BestMove(float phi, const TabuList& tabu, int iter, float best_F, pair<int, int>& cell, int& color, mt19937& rng);
 };
 
 /**
@@ -370,9 +415,9 @@ public:
  * @brief Generates neighbor states by moving colors and adding them to the priority queue.
  *
  * @param Q The priority queue for storing neighbors.
- * @param visited The map of visited states to avoid duplicates.
+ * @param visited Fingerprints of visited states to avoid duplicates.
  */
-void LSC::MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, map<vector<vector<int>>, int>& visited) {
+void LSC::MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, HashSet& visited) {
     vector<int> colors;
     for (int i = 1; i <= square.size(); i++) {
         colors.push_back(i); // List of possible colors
@@ -381,17 +426,23 @@ void LSC::MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare
         for (auto& cell: color_set.second) {
             for (auto& color_next: colors) {
                 if (color_next != color_set.first) { // Avoid moving to the same color
+                    STATS_COUNT(NEIGHBOURS);
+                    uint64_t h = hash ^ zobrist(cell, color_set.first) ^ zobrist(cell, color_next);
+                    if (visited.contains(h)) {
+                        STATS_COUNT(VISITED_REJECTED);
+                        continue; // Skip visited states before copying
+                    }
                     LSC neigh;
                     neigh.n = n; // Copy state
-                    neigh.adj_list = adj_list;
+                    neigh.order = order;
                     neigh.square = square;
                     neigh.V = V;
                     neigh.D = D;
+                    neigh.C = C;
+                    neigh.hash = hash;
                     neigh.l = l;
                     neigh.Move(cell, color_set.first, color_next); // Generate neighbor
-                    if (visited[neigh.square] != 1) {
-                        Q.push({neigh, CL() - neigh.CL()}); // Add to priority queue if not visited
-                    }
+                    Q.push({neigh, CL() - neigh.CL()}); // Add to priority queue if not visited
                 }
             }
         }
@@ -399,48 +450,61 @@ void LSC::MoveGen(priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare
 }
 
 /**
- * @brief Generates neighbor states considering tabu search to avoid revisiting states.
+ * @brief Finds the best non-tabu move of a free cell to another color without copying the state.
+ *
+ * Every (cell, color) pair is scored with gain() and ties are broken at random. A tabu
+ * move is still allowed if it would lead to a state better than the best one found so
+ * far (aspiration criterion).
  *
  * @param phi Penalty weight.
- * @param tt Tabu tenure.
- * @param Q The priority queue for storing neighbors.
- * @param tabu The map of tabu states.
+ * @param tabu The tabu list.
+ * @param iter The current iteration.
+ * @param best_F Fitness of the best state found so far.
+ * @param cell Set to the cell to move.
+ * @param color Set to the color to move the cell to.
+ * @param rng Breaks the ties; each search thread passes its own.
+ * @return true if an allowed move exists, false otherwise.
  */
-void LSC::MoveGen(int phi, int tt, priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>& Q, map<vector<vector<int>>, int>& tabu) {
-    vector<int> colors;
-    for (int i = 1; i <= square.size(); i++) {
-        colors.push_back(i); // List of possible colors
-    }
-    for (auto& color_set: V) {
-        for (auto& cell: color_set.second) {
-            for (auto& color_next: colors) {
-                if (color_next != color_set.first) { // Avoid moving to the same color
-                    LSC neigh;
-                    neigh.n = n; // Copy state
-                    neigh.adj_list = adj_list;
-                    neigh.square = square;
-                    neigh.V = V;
-                    neigh.D = D;
-                    neigh.l = l;
-                    neigh.Move(cell, color_set.first, color_next); // Generate neighbor
-                    if (tabu[neigh.square] == 0) { // Check if not in tabu list
-                        Q.push({neigh, neigh.F(phi)}); // Add to priority queue with fitness
-                    }
-                    tabu[neigh.square] = tt; // Update tabu tenure
-                }
+bool LSC::BestMove(float phi, const TabuList& tabu, int iter, float best_F, pair<int, int>& cell, int& color, mt19937& rng) {
+    int x = square.size();
+    float curr_F = F(phi);
+    bool found = false;
+    float best = 0;
+    int ties = 0;
+    for (auto& v: Cand_set) {
+        int curr = square[v.first][v.second];
+        for (int c = 1; c <= x; c++) {
+            if (c == curr) continue; // Avoid moving to the same color
+            STATS_COUNT(NEIGHBOURS);
+            float g = gain(v, c, phi);
+            if (found && g > best) continue;
+            if (tabu.is_tabu(v, c, iter) && curr_F + g >= best_F) {
+                STATS_COUNT(TABU_REJECTED);
+                continue; // Tabu unless it aspires
+            }
+            if (found && g == best) {
+                ties++;
+                if (rng() % ties != 0) continue;
+            } else {
+                ties = 1;
             }
+            found = true;
+            best = g;
+            cell = v;
+            color = c;
         }
     }
+    return found;
 }
 
-void printSquare(const vector<vector<int>>& square) {
-    cout << "\n";
+void printSquare(const vector<vector<int>>& square, ostream& out = cout) {
+    out << "\n";
     int x = square.size();
     for (int i = 0; i < x; i++) {
         for (int j = 0; j < x; j++) {
-            cout << square[i][j] << " "; // Print each element
+            out << square[i][j] << " "; // Print each element
         }
-        cout << "\n"; // New line after each row
+        out << "\n"; // New line after each row
     }
-    cout << "\n";
+    out << "\n";
 }
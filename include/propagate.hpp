@@ -0,0 +1,220 @@
+#ifndef PROPAGATE_HPP
+#define PROPAGATE_HPP
+
+#include <vector>
+#include <utility>
+#include "domain.hpp"
+
+using namespace std;
+
+/**
+ * @brief Worklist-driven propagation of naked and hidden singles.
+ *
+ * A Latin square has three conjugate views: cell -> symbol, (row, symbol) -> column and
+ * (column, symbol) -> row. The propagator counts the candidates of every entry of every
+ * view, and an entry whose count drops to one is forced. The counts are taken once, in
+ * O(n^3), and then kept in the domain store, so they follow it into every branch of a
+ * search. Placing a symbol only touches the 2(n - 1) neighbours of the cell and the
+ * symbols the cell still had, and erasing a symbol touches one entry of each view, so a
+ * later call costs O(n) per assignment and O(1) per erased symbol. Symbol 0 (the PLITS
+ * "leave empty" color) is ignored.
+ */
+class Propagator {
+public:
+    int x = 0; // Order of the square
+    long assigned = 0; // Cells fixed by the last call to run()
+
+    /**
+     * @brief Creates a propagator for squares of the given order.
+     */
+    Propagator(int order) : x(order) {
+        ;
+    }
+
+    /**
+     * @brief Propagates singles until nothing changes.
+     *
+     * The first call on a domain store counts every entry. Later calls start from the
+     * entries queued by branch() and erased(), so every other change to the store between
+     * calls must be reported through them. After a contradiction the counts are left as
+     * they are, the store being a dead end.
+     *
+     * @param D The domain store; empty cells must have a non-zero cell mask.
+     * @param square The square, 0 for an empty cell. Forced cells are filled in.
+     * @param fixed Receives every cell filled by the propagation.
+     * @return false if a contradiction was found, true otherwise.
+     */
+    bool run(Domain& D, vector<vector<int>>& square, vector<pair<int, int>>& fixed) {
+        assigned = 0;
+        if (D.counts.empty() && !count(D, square)) return fail();
+
+        // Process forced entries
+        while (!events.empty()) {
+            Event e = events.back();
+            events.pop_back();
+            pair<int, int> v;
+            int s;
+            if (e.kind == CELL) {
+                v = {e.unit / x, e.unit % x};
+                if (square[v.first][v.second] != 0) continue;
+                uint64_t m = live(D, v);
+                if (m == 0) return fail();
+                if (m & (m - 1)) continue; // No longer a single
+                s = __builtin_ctzll(m);
+            } else {
+                s = e.symbol;
+                uint64_t used = (e.kind == ROW) ? D.row_used[e.unit] : D.col_used[e.unit];
+                if (used >> s & 1) continue; // Already placed
+                v = {-1, -1};
+                for (int k = 0; k < x; k++) {
+                    pair<int, int> u = (e.kind == ROW) ? make_pair(e.unit, k) : make_pair(k, e.unit);
+                    if (square[u.first][u.second] == 0 && (live(D, u) >> s & 1)) {
+                        v = u;
+                        break;
+                    }
+                }
+                if (v.first < 0) return fail(); // The symbol has no place left in the unit
+            }
+            assign(D, square, v, s);
+            assigned++;
+            fixed.push_back(v);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Places the symbol a branch wrote into cell v, which the store still has empty.
+     */
+    void branch(Domain& D, vector<vector<int>>& square, pair<int, int> v) {
+        if (!D.counts.empty()) assign(D, square, v, square[v.first][v.second]);
+    }
+
+    /**
+     * @brief Reports that symbol s, live until then, was erased from the domain of cell v.
+     */
+    void erased(Domain& D, pair<int, int> v, int s) {
+        if (D.counts.empty()) return;
+        int i = v.first, j = v.second;
+        D.counts[row(i, s)]--;
+        D.counts[col(j, s)]--;
+        if (__builtin_popcountll(live(D, v)) <= 1) events.push_back({CELL, i * x + j, 0});
+        check(D, ROW, i, s);
+        check(D, COL, j, s);
+    }
+
+private:
+    enum Kind { CELL, ROW, COL };
+
+    struct Event {
+        Kind kind;
+        int unit; // Cell index, row or column
+        int symbol; // Symbol for ROW and COL events
+    };
+
+    vector<Event> events; // Worklist of entries that may be forced
+
+    // D.counts[row(i, s)]: empty cells of row i that still allow s; col(j, s) likewise
+    int row(int i, int s) const {
+        return i * (x + 1) + s;
+    }
+
+    int col(int j, int s) const {
+        return (x + j) * (x + 1) + s;
+    }
+
+    uint64_t live(const Domain& D, pair<int, int> v) const {
+        return D.mask(v) & ~uint64_t(1);
+    }
+
+    bool fail() {
+        events.clear();
+        return false;
+    }
+
+    /**
+     * @brief Counts the candidates of every view and queues the entries already forced.
+     *
+     * @return false if a cell or a (unit, symbol) entry has no candidate left.
+     */
+    bool count(Domain& D, const vector<vector<int>>& square) {
+        D.counts.assign(2 * x * (x + 1), 0);
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) {
+                if (square[i][j] != 0) continue;
+                uint64_t m = live(D, {i, j});
+                if (m == 0) return false;
+                if ((m & (m - 1)) == 0) events.push_back({CELL, i * x + j, 0});
+                for (; m; m &= m - 1) {
+                    int s = __builtin_ctzll(m);
+                    D.counts[row(i, s)]++;
+                    D.counts[col(j, s)]++;
+                }
+            }
+        }
+        for (int k = 0; k < x; k++) {
+            for (int s = 1; s <= x; s++) {
+                if (!(D.row_used[k] >> s & 1)) {
+                    if (D.counts[row(k, s)] == 0) return false;
+                    check(D, ROW, k, s);
+                }
+                if (!(D.col_used[k] >> s & 1)) {
+                    if (D.counts[col(k, s)] == 0) return false;
+                    check(D, COL, k, s);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Queues a (unit, symbol) entry that has at most one candidate left.
+     *
+     * An entry with none is a contradiction, found when its event is processed.
+     */
+    void check(const Domain& D, Kind kind, int unit, int s) {
+        if (D.counts[(kind == ROW) ? row(unit, s) : col(unit, s)] <= 1) events.push_back({kind, unit, s});
+    }
+
+    /**
+     * @brief Places symbol s in cell v and updates the counts of all affected entries.
+     */
+    void assign(Domain& D, vector<vector<int>>& square, pair<int, int> v, int s) {
+        int i = v.first, j = v.second;
+        uint64_t bit = uint64_t(1) << s;
+
+        // The cell leaves every view it was counted in
+        uint64_t m = live(D, v);
+        for (uint64_t r = m; r; r &= r - 1) {
+            int t = __builtin_ctzll(r);
+            D.counts[row(i, t)]--;
+            D.counts[col(j, t)]--;
+        }
+
+        // Neighbours lose s
+        for (int k = 0; k < x; k++) {
+            if (k != j && square[i][k] == 0 && (live(D, {i, k}) & bit)) {
+                D.counts[col(k, s)]--;
+                if (__builtin_popcountll(live(D, {i, k})) <= 2) events.push_back({CELL, i * x + k, 0});
+                if (!(D.col_used[k] & bit)) check(D, COL, k, s);
+            }
+            if (k != i && square[k][j] == 0 && (live(D, {k, j}) & bit)) {
+                D.counts[row(k, s)]--;
+                if (__builtin_popcountll(live(D, {k, j})) <= 2) events.push_back({CELL, k * x + j, 0});
+                if (!(D.row_used[k] & bit)) check(D, ROW, k, s);
+            }
+        }
+
+        square[i][j] = s;
+        D.clear(v);
+        D.place(v, s);
+
+        // The other symbols of the cell lost a candidate in this row and column
+        for (uint64_t r = m & ~bit; r; r &= r - 1) {
+            int t = __builtin_ctzll(r);
+            if (!(D.row_used[i] >> t & 1)) check(D, ROW, i, t);
+            if (!(D.col_used[j] >> t & 1)) check(D, COL, j, t);
+        }
+    }
+};
+
+#endif
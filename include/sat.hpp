@@ -0,0 +1,495 @@
+#ifndef SAT_HPP
+#define SAT_HPP
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+/**
+ * @brief Conflict-driven clause learning (CDCL) SAT solver.
+ *
+ * Clauses are given with DIMACS literals (+v / -v, variables numbered from 1). The solver
+ * uses two watched literals per clause, VSIDS branching with phase saving, first-UIP
+ * learning with clause minimisation, Luby restarts and periodic reduction of the learnt
+ * clause database by literal block distance (LBD).
+ */
+class SAT {
+public:
+    long decisions = 0; // Branching decisions
+    long propagations = 0; // Literals propagated
+    long conflicts = 0; // Conflicts analysed
+    long restarts = 0; // Restarts performed
+    long reductions = 0; // Learnt clause database reductions
+    vector<char> model; // Value of every variable (index v - 1) after solve() returned true
+
+    /**
+     * @brief Adds a fresh variable and returns its DIMACS number.
+     */
+    int new_var() {
+        int v = value.size();
+        value.push_back(UNDEF);
+        level.push_back(0);
+        reason.push_back(-1);
+        activity.push_back(0);
+        phase.push_back(0);
+        seen.push_back(0);
+        heap_pos.push_back(-1);
+        watches.emplace_back();
+        watches.emplace_back();
+        heap_insert(v);
+        return v + 1;
+    }
+
+    /**
+     * @brief Returns the number of variables.
+     */
+    int vars() const {
+        return value.size();
+    }
+
+    /**
+     * @brief Returns the number of problem clauses kept in the database.
+     */
+    long clauses() const {
+        return problem;
+    }
+
+    /**
+     * @brief Adds a problem clause. Must be called before solve().
+     *
+     * @param clause DIMACS literals of the clause.
+     * @return false if the formula became trivially unsatisfiable.
+     */
+    bool add_clause(const vector<int>& clause) {
+        if (!ok) return false;
+        vector<int> c;
+        for (int d : clause) c.push_back(lit(d));
+        sort(c.begin(), c.end());
+        vector<int> kept;
+        for (size_t k = 0; k < c.size(); k++) {
+            if (k > 0 && c[k] == c[k - 1]) continue;
+            if (k > 0 && c[k] == (c[k - 1] ^ 1)) return true; // Tautology
+            if (val(c[k]) == TRUE) return true; // Satisfied at the root
+            if (val(c[k]) == UNDEF) kept.push_back(c[k]);
+        }
+        if (kept.empty()) return ok = false;
+        if (kept.size() == 1) {
+            enqueue(kept[0], -1);
+            return ok = (propagate() < 0);
+        }
+        attach(store(kept, false, 0));
+        problem++;
+        return true;
+    }
+
+    /**
+     * @brief Writes the formula in DIMACS CNF format.
+     *
+     * Root-level assignments are written as unit clauses.
+     */
+    void write_dimacs(ostream& out) const {
+        out << "p cnf " << vars() << " " << problem + trail.size() << "\n";
+        for (int l : trail) out << dimacs(l) << " 0\n";
+        for (size_t c = 0; c < header.size(); c++) {
+            if (header[c].learnt || header[c].deleted) continue;
+            for (int k = 0; k < header[c].size; k++) out << dimacs(lits[header[c].start + k]) << " ";
+            out << "0\n";
+        }
+    }
+
+    /**
+     * @brief Searches for a satisfying assignment.
+     *
+     * @return true if the formula is satisfiable; model then holds the assignment.
+     */
+    bool solve() {
+        if (!ok || propagate() >= 0) return false;
+        max_learnts = max(1000.0, problem / 3.0);
+        for (int r = 0;; r++) {
+            int status = search(luby(r) * RESTART_BASE);
+            if (status == FALSE) return false;
+            if (status == TRUE) break;
+            restarts++;
+            max_learnts *= 1.05;
+        }
+        model.assign(vars(), 0);
+        for (int v = 0; v < vars(); v++) model[v] = (value[v] == TRUE);
+        cancel_until(0);
+        return true;
+    }
+
+private:
+    constexpr static int8_t FALSE = 0, TRUE = 1, UNDEF = 2;
+    constexpr static int RESTART_BASE = 100; // Conflicts in one Luby unit
+    constexpr static double VAR_DECAY = 0.95, CLAUSE_DECAY = 0.999;
+
+    struct Header {
+        int start; // Offset of the first literal in lits
+        int size; // Number of literals
+        int lbd; // Literal block distance when learnt
+        float activity; // Bumped when the clause takes part in a conflict
+        bool learnt, deleted;
+    };
+
+    struct Watch {
+        int cref; // Watching clause
+        int blocker; // Another literal of the clause; the clause is skipped while it is true
+    };
+
+    bool ok = true; // False once the formula is known to be unsatisfiable
+    long problem = 0; // Problem clauses with two or more literals
+    vector<Header> header; // Clause headers, indexed by clause reference
+    vector<int> lits; // Literals of all clauses
+    vector<int> learnts; // References of the live learnt clauses
+    vector<vector<Watch>> watches; // watches[l]: clauses watching literal l
+
+    vector<int8_t> value; // Value of every variable
+    vector<int> level; // Decision level of every assigned variable
+    vector<int> reason; // Clause that implied every variable, -1 for decisions
+    vector<int> trail; // Assigned literals in order
+    vector<int> trail_lim; // Start of every decision level in the trail
+    size_t qhead = 0; // Next trail literal to propagate
+
+    vector<double> activity; // VSIDS score of every variable
+    double var_inc = 1, clause_inc = 1;
+    vector<char> phase; // Last value of every variable
+    vector<int> heap, heap_pos; // Max-heap of variables by activity
+    vector<char> seen;
+    double max_learnts = 0;
+
+    // Literals are 2v for x_v and 2v + 1 for its negation
+    static int lit(int d) {
+        return d > 0 ? 2 * (d - 1) : 2 * (-d - 1) + 1;
+    }
+
+    static int dimacs(int l) {
+        return (l & 1) ? -(l / 2 + 1) : l / 2 + 1;
+    }
+
+    int8_t val(int l) const {
+        int8_t v = value[l >> 1];
+        return v == UNDEF ? UNDEF : v ^ (l & 1);
+    }
+
+    int decision_level() const {
+        return trail_lim.size();
+    }
+
+    int store(const vector<int>& c, bool learnt, int lbd) {
+        header.push_back({(int)lits.size(), (int)c.size(), lbd, 0, learnt, false});
+        lits.insert(lits.end(), c.begin(), c.end());
+        return header.size() - 1;
+    }
+
+    void attach(int cref) {
+        int* c = &lits[header[cref].start];
+        watches[c[0]].push_back({cref, c[1]});
+        watches[c[1]].push_back({cref, c[0]});
+    }
+
+    void enqueue(int l, int from) {
+        int v = l >> 1;
+        value[v] = !(l & 1);
+        level[v] = decision_level();
+        reason[v] = from;
+        trail.push_back(l);
+    }
+
+    /**
+     * @brief Propagates the trail with the two-watched-literal scheme.
+     *
+     * @return The conflicting clause, or -1.
+     */
+    int propagate() {
+        while (qhead < trail.size()) {
+            int f = trail[qhead++] ^ 1; // Literal that just became false
+            propagations++;
+            vector<Watch>& ws = watches[f];
+            size_t i = 0, j = 0;
+            while (i < ws.size()) {
+                Watch w = ws[i++];
+                if (val(w.blocker) == TRUE) {
+                    ws[j++] = w;
+                    continue;
+                }
+                int* c = &lits[header[w.cref].start];
+                int n = header[w.cref].size;
+                if (c[0] == f) swap(c[0], c[1]);
+                if (val(c[0]) == TRUE) {
+                    ws[j++] = {w.cref, c[0]};
+                    continue;
+                }
+                bool moved = false;
+                for (int k = 2; k < n; k++) {
+                    if (val(c[k]) != FALSE) {
+                        swap(c[1], c[k]);
+                        watches[c[1]].push_back({w.cref, c[0]});
+                        moved = true;
+                        break;
+                    }
+                }
+                if (moved) continue;
+                ws[j++] = {w.cref, c[0]};
+                if (val(c[0]) == FALSE) {
+                    while (i < ws.size()) ws[j++] = ws[i++];
+                    ws.resize(j);
+                    qhead = trail.size();
+                    return w.cref;
+                }
+                enqueue(c[0], w.cref);
+            }
+            ws.resize(j);
+        }
+        return -1;
+    }
+
+    void cancel_until(int lvl) {
+        if (decision_level() <= lvl) return;
+        for (int k = trail.size() - 1; k >= trail_lim[lvl]; k--) {
+            int v = trail[k] >> 1;
+            phase[v] = value[v];
+            value[v] = UNDEF;
+            reason[v] = -1;
+            if (heap_pos[v] < 0) heap_insert(v);
+        }
+        trail.resize(trail_lim[lvl]);
+        trail_lim.resize(lvl);
+        qhead = trail.size();
+    }
+
+    /**
+     * @brief First-UIP conflict analysis.
+     *
+     * @param confl The conflicting clause.
+     * @param learnt Receives the learnt clause, asserting literal first.
+     * @return The level to backjump to.
+     */
+    int analyze(int confl, vector<int>& learnt, int& lbd) {
+        learnt.assign(1, -1);
+        int paths = 0, p = -1;
+        int index = trail.size() - 1;
+        do {
+            Header& h = header[confl];
+            if (h.learnt) bump_clause(confl);
+            for (int k = (p < 0) ? 0 : 1; k < h.size; k++) {
+                int q = lits[h.start + k];
+                int v = q >> 1;
+                if (seen[v] || level[v] == 0) continue;
+                seen[v] = 1;
+                bump_var(v);
+                if (level[v] >= decision_level()) paths++;
+                else learnt.push_back(q);
+            }
+            while (!seen[trail[index--] >> 1]) {
+                ;
+            }
+            p = trail[index + 1];
+            confl = reason[p >> 1];
+            seen[p >> 1] = 0;
+            paths--;
+        } while (paths > 0);
+        learnt[0] = p ^ 1;
+
+        // Drop literals implied by the rest of the clause
+        vector<int> marked(learnt.begin() + 1, learnt.end());
+        size_t j = 1;
+        for (size_t k = 1; k < learnt.size(); k++) {
+            int r = reason[learnt[k] >> 1];
+            bool redundant = (r >= 0);
+            for (int m = 1; redundant && m < header[r].size; m++) {
+                int v = lits[header[r].start + m] >> 1;
+                if (!seen[v] && level[v] > 0) redundant = false;
+            }
+            if (!redundant) learnt[j++] = learnt[k];
+        }
+        learnt.resize(j);
+        for (int l : marked) seen[l >> 1] = 0;
+
+        // Put a literal of the highest remaining level second
+        int back = 0;
+        for (size_t k = 1; k < learnt.size(); k++) {
+            if (level[learnt[k] >> 1] > level[learnt[1] >> 1]) swap(learnt[1], learnt[k]);
+        }
+        if (learnt.size() > 1) back = level[learnt[1] >> 1];
+
+        vector<int> levels;
+        for (int l : learnt) levels.push_back(level[l >> 1]);
+        sort(levels.begin(), levels.end());
+        lbd = unique(levels.begin(), levels.end()) - levels.begin();
+        return back;
+    }
+
+    /**
+     * @brief Runs CDCL until a result or the given number of conflicts.
+     *
+     * @return TRUE, FALSE, or UNDEF when the restart limit was reached.
+     */
+    int search(long limit) {
+        vector<int> learnt;
+        for (long local = 0;;) {
+            int confl = propagate();
+            if (confl >= 0) {
+                conflicts++;
+                local++;
+                if (decision_level() == 0) return FALSE;
+                int lbd;
+                int back = analyze(confl, learnt, lbd);
+                cancel_until(back);
+                if (learnt.size() == 1) {
+                    enqueue(learnt[0], -1);
+                } else {
+                    int cref = store(learnt, true, lbd);
+                    attach(cref);
+                    learnts.push_back(cref);
+                    bump_clause(cref);
+                    enqueue(learnt[0], cref);
+                }
+                var_inc /= VAR_DECAY;
+                clause_inc /= CLAUSE_DECAY;
+            } else {
+                if (local >= limit) {
+                    cancel_until(0);
+                    return UNDEF;
+                }
+                if ((double)learnts.size() - trail.size() >= max_learnts) reduce_db();
+                int v = -1;
+                while (!heap.empty()) {
+                    int top = heap_pop();
+                    if (value[top] == UNDEF) {
+                        v = top;
+                        break;
+                    }
+                }
+                if (v < 0) return TRUE; // Every variable is assigned
+                decisions++;
+                trail_lim.push_back(trail.size());
+                enqueue(2 * v + (phase[v] == TRUE ? 0 : 1), -1);
+            }
+        }
+    }
+
+    bool locked(int cref) const {
+        int l = lits[header[cref].start];
+        return val(l) == TRUE && reason[l >> 1] == cref;
+    }
+
+    /**
+     * @brief Deletes the less useful half of the learnt clauses and compacts the database.
+     *
+     * Clauses with an LBD of two or less ("glue" clauses) and clauses that are the reason
+     * of an assignment are always kept.
+     */
+    void reduce_db() {
+        reductions++;
+        sort(learnts.begin(), learnts.end(), [&](int a, int b) {
+            if (header[a].lbd != header[b].lbd) return header[a].lbd > header[b].lbd;
+            return header[a].activity < header[b].activity;
+        });
+        vector<int> kept;
+        for (size_t k = 0; k < learnts.size(); k++) {
+            int c = learnts[k];
+            if (k < learnts.size() / 2 && header[c].lbd > 2 && !locked(c)) header[c].deleted = true;
+            else kept.push_back(c);
+        }
+        learnts.swap(kept);
+
+        // Compact the literals and rebuild the watch lists
+        vector<int> packed;
+        packed.reserve(lits.size());
+        for (auto& w : watches) w.clear();
+        for (size_t c = 0; c < header.size(); c++) {
+            Header& h = header[c];
+            if (h.deleted || h.size == 0) {
+                h.size = 0;
+                continue;
+            }
+            int start = packed.size();
+            packed.insert(packed.end(), lits.begin() + h.start, lits.begin() + h.start + h.size);
+            h.start = start;
+        }
+        lits.swap(packed);
+        for (size_t c = 0; c < header.size(); c++) {
+            if (header[c].size > 0) attach(c);
+        }
+    }
+
+    void bump_var(int v) {
+        if ((activity[v] += var_inc) > 1e100) {
+            for (double& a : activity) a *= 1e-100;
+            var_inc *= 1e-100;
+        }
+        if (heap_pos[v] >= 0) heap_up(heap_pos[v]);
+    }
+
+    void bump_clause(int cref) {
+        if ((header[cref].activity += clause_inc) > 1e20) {
+            for (int c : learnts) header[c].activity *= 1e-20;
+            clause_inc *= 1e-20;
+        }
+    }
+
+    /**
+     * @brief Returns the r-th element (from 0) of the Luby sequence 1, 1, 2, 1, 1, 2, 4, ...
+     */
+    static long luby(int r) {
+        long size = 1;
+        int seq = 0;
+        while (size < r + 1) {
+            seq++;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != r) {
+            size = (size - 1) / 2;
+            seq--;
+            r = r % size;
+        }
+        return 1L << seq;
+    }
+
+    void heap_insert(int v) {
+        heap_pos[v] = heap.size();
+        heap.push_back(v);
+        heap_up(heap_pos[v]);
+    }
+
+    int heap_pop() {
+        int top = heap[0];
+        heap[0] = heap.back();
+        heap_pos[heap[0]] = 0;
+        heap.pop_back();
+        heap_pos[top] = -1;
+        if (!heap.empty()) heap_down(0);
+        return top;
+    }
+
+    void heap_up(int i) {
+        int v = heap[i];
+        while (i > 0 && activity[heap[(i - 1) / 2]] < activity[v]) {
+            heap[i] = heap[(i - 1) / 2];
+            heap_pos[heap[i]] = i;
+            i = (i - 1) / 2;
+        }
+        heap[i] = v;
+        heap_pos[v] = i;
+    }
+
+    void heap_down(int i) {
+        int v = heap[i];
+        int n = heap.size();
+        while (2 * i + 1 < n) {
+            int child = 2 * i + 1;
+            if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]]) child++;
+            if (activity[heap[child]] <= activity[v]) break;
+            heap[i] = heap[child];
+            heap_pos[heap[i]] = i;
+            i = child;
+        }
+        heap[i] = v;
+        heap_pos[v] = i;
+    }
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef SEED_HPP
+#define SEED_HPP
+
+#include <cstdlib>
+#include <string>
+
+/**
+ * @brief Returns the seed of the run, taken from the LSC_SEED environment variable so
+ * that benchmark runs can be reproduced.
+ *
+ * @param fallback The seed to use when LSC_SEED is not set.
+ */
+inline unsigned run_seed(unsigned fallback) {
+    static const char* env = std::getenv("LSC_SEED");
+    return env != nullptr ? (unsigned)std::stoul(env) : fallback;
+}
+
+#endif
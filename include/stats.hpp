@@ -0,0 +1,231 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+/**
+ * @brief Hot-path counters and phase timers, compiled in with -DLSC_STATS.
+ *
+ * Every thread counts into a block of its own, so counting costs no synchronisation.
+ * STATS_RESET() starts an instance, which lasts until the end of the enclosing scope, and
+ * STATS_REPORT() prints its counts as one JSON object. An instance solved on its own counts
+ * the blocks of all threads; when several overlap, each is solved on one thread and only
+ * counts that thread's block, so no thread touches the live block of another (see Scope).
+ * Phase times are summed over threads. At exit the totals over all instances are also
+ * written to the file named by the LSC_STATS_JSON environment variable, if it is set.
+ *
+ * Without LSC_STATS every macro expands to nothing.
+ */
+#ifdef LSC_STATS
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+namespace stats {
+
+enum Counter {
+    CL_CALLS,         // CL() calls
+    NEIGHBOURS,       // Moves generated or scored by MoveGen() and BestMove()
+    TABU_REJECTED,    // Moves skipped as tabu
+    VISITED_REJECTED, // Moves skipped as already visited
+    MOVES,            // Move() applications
+    MIS_ROUNDS,       // Independent sets extracted by gen_solns()
+    RESTARTS,         // Failed colourings retried by mis_par, islands restarted by plits_par
+    COUNTERS
+};
+
+enum Phase {
+    PREPROCESS, // LSC construction and propagation
+    POPULATION, // Initial population of PLITS
+    PHASE1,     // First PLITS phase
+    PHASE2,     // Second PLITS phase
+    PHASES
+};
+
+const char* const COUNTER_NAMES[COUNTERS] = {"cl_calls", "neighbours", "tabu_rejected", "visited_rejected", "moves", "mis_rounds", "restarts"};
+const char* const PHASE_NAMES[PHASES] = {"preprocess", "population", "phase1", "phase2"};
+
+struct Block {
+    uint64_t count[COUNTERS] = {};
+    double seconds[PHASES] = {};
+
+    void add(const Block& b) {
+        for (int c = 0; c < COUNTERS; c++) count[c] += b.count[c];
+        for (int p = 0; p < PHASES; p++) seconds[p] += b.seconds[p];
+    }
+
+    void sub(const Block& b) {
+        for (int c = 0; c < COUNTERS; c++) count[c] -= b.count[c];
+        for (int p = 0; p < PHASES; p++) seconds[p] -= b.seconds[p];
+    }
+};
+
+/**
+ * @brief The blocks of the live threads, and the counts of threads that exited.
+ */
+struct Registry {
+    std::mutex lock;
+    std::vector<Block*> blocks;
+    Block retired; // Counts of exited threads since the last reset
+    Block run;     // Counts of earlier resets
+    int active = 0; // Instances being solved
+    long started = 0; // Instances started
+
+    Block merged() {
+        Block b = retired;
+        for (auto* t : blocks) b.add(*t);
+        return b;
+    }
+};
+
+void write(std::ostream& out, const Block& b) {
+    out << "{";
+    for (int c = 0; c < COUNTERS; c++) out << "\"" << COUNTER_NAMES[c] << "\": " << b.count[c] << ", ";
+    out << "\"seconds\": {";
+    for (int p = 0; p < PHASES; p++) out << "\"" << PHASE_NAMES[p] << "\": " << b.seconds[p] << (p + 1 < PHASES ? ", " : "");
+    out << "}}";
+}
+
+Registry& registry();
+
+/**
+ * @brief Writes the totals of the run to LSC_STATS_JSON.
+ */
+void dump() {
+    const char* path = std::getenv("LSC_STATS_JSON");
+    if (path == nullptr) return;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    Block b = r.run;
+    b.add(r.merged());
+    std::ofstream out(path);
+    write(out, b);
+    out << "\n";
+}
+
+Registry& registry() {
+    static Registry* r = []() {
+        std::atexit(dump);
+        return new Registry(); // Never destroyed, threads may still exit after main
+    }();
+    return *r;
+}
+
+/**
+ * @brief Registers the block of a thread, and retires it when the thread exits.
+ */
+struct Local {
+    Block block;
+
+    Local() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.blocks.push_back(&block);
+    }
+
+    ~Local() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.retired.add(block);
+        r.blocks.erase(std::find(r.blocks.begin(), r.blocks.end(), &block));
+    }
+};
+
+inline Block& local() {
+    thread_local Local l;
+    return l.block;
+}
+
+/**
+ * @brief Adds the time until the end of its scope to a phase.
+ */
+class Timer {
+public:
+    Timer(Phase p) : phase(p), start(std::chrono::steady_clock::now()) {
+        ;
+    }
+
+    ~Timer() {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        local().seconds[phase] += d.count();
+    }
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Counts one instance from its construction to its destruction.
+ *
+ * An instance started while no other is being solved resets every block, as every other
+ * thread is idle, and reports all of them if still no other instance has started by then.
+ * Otherwise it only reads its own thread's block and reports what it added since the
+ * start.
+ */
+class Scope {
+public:
+    Scope() : mine(local()) { // Registers the thread before the lock is taken
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        id = ++r.started;
+        alone = ++r.active == 1;
+        if (alone) {
+            r.run.add(r.merged());
+            r.retired = Block();
+            for (auto* t : r.blocks) *t = Block();
+        }
+        base = mine;
+    }
+
+    ~Scope() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.active--;
+    }
+
+    /**
+     * @brief Prints the counts of the instance.
+     */
+    void report(std::ostream& out) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        out << "Stats: ";
+        if (alone && r.started == id) {
+            write(out, r.merged());
+        } else {
+            Block b = mine;
+            b.sub(base);
+            write(out, b);
+        }
+        out << "\n";
+    }
+
+private:
+    Block& mine; // The block of the thread solving the instance
+    Block base; // Its counts at the start
+    long id; // Instances started before, this one included
+    bool alone; // No other instance was being solved at the start
+};
+
+}
+
+#define STATS_COUNT(c) (stats::local().count[stats::c]++)
+#define STATS_PHASE(p) stats::Timer stats_timer_##p(stats::p)
+#define STATS_RESET() stats::Scope stats_scope
+#define STATS_REPORT(out) stats_scope.report(out)
+
+#else
+
+#define STATS_COUNT(c) ((void)0)
+#define STATS_PHASE(p) ((void)0)
+#define STATS_RESET() ((void)0)
+#define STATS_REPORT(out) ((void)0)
+
+#endif
+
+#endif
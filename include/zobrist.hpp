@@ -0,0 +1,120 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * @brief Returns the Zobrist key of symbol c sitting in cell v.
+ *
+ * Keys are derived from the (cell, symbol) triple with the splitmix64 finaliser, so
+ * they are deterministic and need no table. Empty cells (symbol 0) contribute nothing.
+ */
+inline uint64_t zobrist(pair<int, int> v, int c) {
+    if (c == 0) return 0;
+    uint64_t z = ((uint64_t)v.first << 42) ^ ((uint64_t)v.second << 21) ^ (uint64_t)c;
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Returns the Zobrist hash of a whole square.
+ */
+inline uint64_t zobrist(const vector<vector<int>>& square) {
+    uint64_t h = 0;
+    for (int i = 0; i < (int)square.size(); i++) {
+        for (int j = 0; j < (int)square[i].size(); j++) {
+            h ^= zobrist({i, j}, square[i][j]);
+        }
+    }
+    return h;
+}
+
+/**
+ * @brief Set of state fingerprints, stored as one flat array.
+ */
+class HashSet {
+public:
+    vector<uint64_t> keys; // Fingerprints, 0 for an empty slot
+    size_t count = 0; // Number of occupied slots
+
+    /**
+     * @brief Creates an empty set.
+     *
+     * @param capacity Initial number of slots, rounded up to a power of two.
+     */
+    HashSet(size_t capacity = 1024) {
+        size_t c = 16;
+        while (c < capacity) c <<= 1;
+        keys.assign(c, 0);
+    }
+
+    /**
+     * @brief Checks if a fingerprint is in the set.
+     */
+    bool contains(uint64_t h) const {
+        h = h ? h : 1;
+        size_t i = slot(h);
+        while (keys[i] != 0) {
+            if (keys[i] == h) return true;
+            i = (i + 1) & (keys.size() - 1);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Inserts a fingerprint.
+     *
+     * @return true if the fingerprint was not in the set before.
+     */
+    bool insert(uint64_t h) {
+        h = h ? h : 1;
+        if (2 * (count + 1) > keys.size()) grow();
+        size_t i = slot(h);
+        while (keys[i] != 0) {
+            if (keys[i] == h) return false;
+            i = (i + 1) & (keys.size() - 1);
+        }
+        keys[i] = h;
+        count++;
+        return true;
+    }
+
+    /**
+     * @brief Removes all fingerprints, keeping the allocated slots.
+     */
+    void clear() {
+        fill(keys.begin(), keys.end(), 0);
+        count = 0;
+    }
+
+    /**
+     * @brief Returns the number of stored fingerprints.
+     */
+    size_t size() const {
+        return count;
+    }
+
+private:
+    size_t slot(uint64_t h) const {
+        return (h ^ (h >> 32)) & (keys.size() - 1);
+    }
+
+    void grow() {
+        vector<uint64_t> old;
+        old.swap(keys);
+        keys.assign(2 * old.size(), 0);
+        count = 0;
+        for (uint64_t h: old) {
+            if (h != 0) insert(h);
+        }
+    }
+};
+
+#endif
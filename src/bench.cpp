@@ -0,0 +1,292 @@
+#include <chrono>
+#include <cmath>
+#include <regex>
+#include <cstring>
+#include <csignal>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "io.hpp"
+
+using namespace std;
+
+/**
+ * @brief A benchmarked program, run from the working directory.
+ */
+struct Algorithm
+{
+    string name;
+    bool parallel; // Takes the thread count before the instance file
+    string program = ""; // The program to run, the name if empty
+    vector<string> flags = {}; // Passed after the instance file
+};
+
+const vector<Algorithm> ALGORITHMS = {
+    {"bfs", false}, {"bfs_par", true}, {"dfs", false}, {"dfs_par", true},
+    {"bestfs", false}, {"bestfs_par", true}, {"plits_seq", false}, {"plits_par", true},
+    {"memetic_par", true},
+    {"mis_par", true}, {"mis_par_dsatur", true, "mis_par", {"--engine", "dsatur"}}, {"dlx", false}, {"sat", false},
+};
+
+/**
+ * @brief Outcome of one run.
+ */
+struct Run
+{
+    bool solved = false;
+    bool timeout = false;
+    double seconds = 0; // Solver time reported by the program, wall time if it reports none
+    double steps = -1;  // Steps, nodes, decisions or attempts, -1 if not reported
+};
+
+/**
+ * @brief Returns true if the lines starting at first hold a Latin square that completes the partial square.
+ */
+bool completes(const vector<vector<int>>& partial, const vector<vector<int>>& rows, size_t first)
+{
+    int x = partial.size();
+    vector<char> seen_row(x * (x + 1)), seen_col(x * (x + 1));
+    for (int i = 0; i < x; i++)
+    {
+        for (int j = 0; j < x; j++)
+        {
+            int v = rows[first + i][j];
+            if (v < 1 || v > x || (partial[i][j] != 0 && partial[i][j] != v)) return false;
+            if (seen_row[i * (x + 1) + v] || seen_col[j * (x + 1) + v]) return false;
+            seen_row[i * (x + 1) + v] = seen_col[j * (x + 1) + v] = 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the outcome of a run from the program output.
+ *
+ * A run is solved if the output holds a completion of the instance, printed as x lines of x symbols.
+ */
+void parse(const string& text, const vector<vector<int>>& partial, Run& run)
+{
+    static const regex elapsed("^elapsed time: ([0-9.e+-]+)s", regex::icase);
+    static const regex steps("^(Steps taken[^:]*|Nodes expanded|Nodes|Decisions|Attempts): ([0-9.e+]+)");
+    size_t x = partial.size();
+    vector<vector<int>> rows; // Consecutive lines of exactly x numbers
+    istringstream in(text);
+    string line;
+    smatch m;
+    while (getline(in, line))
+    {
+        if (regex_search(line, m, elapsed)) run.seconds = stod(m[1]);
+        if (regex_search(line, m, steps)) run.steps = stod(m[2]);
+
+        istringstream tokens(line);
+        vector<int> row;
+        int v;
+        while (tokens >> v) row.push_back(v);
+        if (row.size() != x || !(tokens.eof()))
+        {
+            rows.clear();
+            continue;
+        }
+        rows.push_back(row);
+        if (rows.size() >= x && completes(partial, rows, rows.size() - x)) run.solved = true;
+    }
+}
+
+/**
+ * @brief Runs a program on one instance file, killing it after the timeout.
+ */
+Run execute(const Algorithm& alg, const string& file, const vector<vector<int>>& partial, int threads, unsigned seed, double timeout)
+{
+    int out[2];
+    if (pipe(out) < 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(out[1], STDOUT_FILENO);
+        dup2(out[1], STDERR_FILENO);
+        close(out[0]);
+        close(out[1]);
+        setenv("LSC_SEED", to_string(seed).c_str(), 1);
+        string program = "./" + (alg.program.empty() ? alg.name : alg.program), t = to_string(threads);
+        vector<string> args = {program};
+        if (alg.parallel) args.insert(args.end(), {t, file});
+        else args.insert(args.end(), {file, "1"});
+        args.insert(args.end(), alg.flags.begin(), alg.flags.end());
+        vector<char*> argv;
+        for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(program.c_str(), argv.data());
+        perror(program.c_str());
+        _exit(127);
+    }
+    close(out[1]);
+
+    Run run;
+    string text;
+    char buffer[1 << 16];
+    while (true)
+    {
+        std::chrono::duration<double> spent = std::chrono::steady_clock::now() - start;
+        int left = (timeout - spent.count()) * 1000;
+        if (left <= 0)
+        {
+            run.timeout = true;
+            break;
+        }
+        pollfd p = {out[0], POLLIN, 0};
+        if (poll(&p, 1, left) == 0) continue;
+        ssize_t n = read(out[0], buffer, sizeof(buffer));
+        if (n <= 0) break;
+        text.append(buffer, n);
+    }
+    if (run.timeout) kill(pid, SIGKILL);
+    close(out[0]);
+    waitpid(pid, nullptr, 0);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    if (run.timeout)
+    {
+        run.seconds = timeout;
+        return run;
+    }
+    run.seconds = wall.count();
+    parse(text, partial, run);
+    return run;
+}
+
+/**
+ * @brief Returns the q-quantile of the values (nearest rank).
+ */
+double quantile(vector<double> values, double q)
+{
+    if (values.empty()) return -1;
+    sort(values.begin(), values.end());
+    size_t rank = ceil(q * values.size());
+    return values[max<size_t>(rank, 1) - 1];
+}
+
+int main(int argc, char *argv[])
+{
+    int seeds = 5, warmup = 1, threads = thread::hardware_concurrency();
+    double timeout = 10;
+    string output = "results.csv", selected;
+    vector<string> files;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "-a" && i + 1 < argc) selected = argv[++i];
+        else if (arg == "-s" && i + 1 < argc) seeds = stoi(argv[++i]);
+        else if (arg == "-w" && i + 1 < argc) warmup = stoi(argv[++i]);
+        else if (arg == "-t" && i + 1 < argc) timeout = stod(argv[++i]);
+        else if (arg == "-j" && i + 1 < argc) threads = stoi(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else if (arg[0] == '-')
+        {
+            cout << "Usage: " << argv[0] << " [-a alg,...] [-s seeds] [-w warm-up runs] [-t timeout (s)] [-j threads] [-o results.csv] [instance files]\n";
+            return 1;
+        }
+        else files.push_back(arg);
+    }
+    if (files.empty())
+    {
+        // The instance suite
+        DIR* dir = opendir("instances");
+        for (dirent* e = dir ? readdir(dir) : nullptr; e != nullptr; e = readdir(dir))
+        {
+            string name = e->d_name;
+            if (name.size() > 4 && name.substr(name.size() - 4) == ".txt") files.push_back("instances/" + name);
+        }
+        if (dir) closedir(dir);
+        sort(files.begin(), files.end());
+    }
+
+    vector<Algorithm> algorithms;
+    for (auto& alg : ALGORITHMS)
+    {
+        if (selected.empty() || ("," + selected + ",").find("," + alg.name + ",") != string::npos) algorithms.push_back(alg);
+    }
+
+    // Every instance gets a file of its own so that each run solves exactly one
+    struct Instance { string name, file; vector<vector<int>> square; };
+    vector<Instance> suite;
+    for (auto& path : files)
+    {
+        ifstream in(path);
+        vector<vector<int>> square;
+        for (int k = 0; read_instance(in, square); k++)
+        {
+            char tmp[] = "/tmp/lsc_benchXXXXXX";
+            int fd = mkstemp(tmp);
+            if (fd < 0)
+            {
+                perror("mkstemp");
+                return 1;
+            }
+            close(fd);
+            ofstream f(tmp);
+            write_instance(f, square);
+            suite.push_back({path + (k > 0 ? "#" + to_string(k) : ""), tmp, square});
+        }
+    }
+    stable_sort(suite.begin(), suite.end(), [](const Instance& a, const Instance& b) { return a.square.size() < b.square.size(); });
+
+    ofstream csv(output);
+    csv << "algorithm,instance,order,threads,runs,success_rate,median_s,p90_s,median_steps,timeouts\n";
+    cout << "Instances: " << suite.size() << ", seeds: " << seeds << ", warm-up runs: " << warmup << ", timeout: " << timeout << "s, threads: " << threads << "\n";
+
+    auto start = std::chrono::system_clock::now();
+    for (auto& alg : algorithms)
+    {
+        size_t given_up = SIZE_MAX; // Order at which every run timed out
+        int order_timeouts = 0, order_runs = 0;
+        for (size_t k = 0; k < suite.size(); k++)
+        {
+            auto& inst = suite[k];
+            if (inst.square.size() > given_up)
+            {
+                cout << alg.name << " " << inst.name << ": skipped\n";
+                continue;
+            }
+            int t = alg.parallel ? threads : 1;
+            for (int w = 0; w < warmup; w++) execute(alg, inst.file, inst.square, t, 0, timeout);
+
+            vector<double> seconds, steps;
+            int solved = 0, timeouts = 0;
+            for (int s = 1; s <= seeds; s++)
+            {
+                Run run = execute(alg, inst.file, inst.square, t, s, timeout);
+                seconds.push_back(run.seconds);
+                if (run.steps >= 0) steps.push_back(run.steps);
+                solved += run.solved;
+                timeouts += run.timeout;
+            }
+            double rate = (double)solved / seeds;
+            cout << alg.name << " " << inst.name << ": success " << rate << ", median " << quantile(seconds, 0.5)
+                 << "s, p90 " << quantile(seconds, 0.9) << "s, timeouts " << timeouts << "\n";
+            csv << alg.name << "," << inst.name << "," << inst.square.size() << "," << t << "," << seeds << "," << rate << ","
+                << quantile(seconds, 0.5) << "," << quantile(seconds, 0.9) << "," << quantile(steps, 0.5) << "," << timeouts << "\n";
+
+            // Larger orders are hopeless once a whole order times out
+            bool last_of_order = k + 1 == suite.size() || suite[k + 1].square.size() != inst.square.size();
+            order_timeouts += timeouts;
+            order_runs += seeds;
+            if (last_of_order)
+            {
+                if (order_runs > 0 && order_timeouts == order_runs) given_up = inst.square.size();
+                order_timeouts = order_runs = 0;
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+
+    for (auto& inst : suite) remove(inst.file.c_str());
+    cout << "Results written to " << output << "\n";
+    cout << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
@@ -1,63 +1,36 @@
-#include "lsc.hpp"
+#include "bestfs.hpp"
+#include "io.hpp"
 
 using namespace std;
 
-/**
- * @brief Performs a Best-First Search (BestFS) on the given Latin square coloring problem.
- *
- * @param S The initial LSC instance to start the search from.
- */
-void BestFS(LSC S) {
-    int steps = 0;
-    priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare> Open;
-    Open.push({S, S.CL()});
-    bool solved = false;
+int main(int argc, char *argv[]) {
+    string path = (argc > 1) ? argv[1] : "-"; // Instance file, stdin by default
+    int workers = (argc > 2) ? stoi(argv[2]) : thread::hardware_concurrency(); // Instances solved at once
 
-    map<vector<vector<int>>, int> Close;
-
-    while(!Open.empty()) {
-        steps++;
-        auto curr = Open.top();
-        // curr.first.printSquare();
-        // cout << "\n";
-        Open.pop();
-        if (curr.first.GoalTest()) {
-            solved = true;
-            curr.first.printSquare();
-            break;
-        }
-        Close[curr.first.square]++;
-
-        curr.first.MoveGen(Open, Close);
-    }
-    if (solved) {
-        cout << "Steps taken: " << steps << "\n";
-    }
-}
-
-int main() {
-    LSC test(
-        {{1, 0, 0, 0},
-         {0, 0, 0, 0},
-         {0, 0, 0, 0},
-         {3, 0, 0, 0},
-        }
-        // {{3, 0, 0},
-        //  {0, 0, 0},
-        //  {1, 0, 0}}
-        // {{1, 0, 0, 0},
-        //  {0, 0, 0, 4},
-        //  {0, 2, 0, 0},
-        //  {3, 0, 0, 0},
-        // }
-    );
-    test.printSquare();
-    cout << "\n";
     std::chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
-    BestFS(test);
+    long count = run_batch(path, workers, [&](long id, const vector<vector<int>>& partial, ostream& out) {
+        STATS_RESET();
+        LSC test(partial, run_seed(time(0)) + id);
+        if (!test.error.empty()) {
+            out << test.error;
+            return;
+        }
+        test.printSquare(out);
+        out << "\n";
+        auto start = std::chrono::system_clock::now();
+        LSC goal;
+        long steps;
+        if (BestFS(test, goal, steps)) {
+            goal.printSquare(out);
+            out << "Steps taken: " << steps << "\n";
+        }
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+        out << "elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
     end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "elapsed time: " << elapsed_seconds.count() << "s\n";
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
     return 0;
 }
@@ -0,0 +1,335 @@
+#include <omp.h>
+#include <atomic>
+#include <climits>
+#include <thread>
+#include <memory>
+#include "bestfs.hpp"
+#include "io.hpp"
+
+using namespace std;
+
+/**
+ * @brief A search state sent to the thread that owns it.
+ *
+ * Most generated states are never expanded, so a state is sent as its parent, shared by
+ * all its siblings, plus the one move that produced it.
+ */
+struct Message {
+    Message* next; // Next message in the mailbox
+    int priority; // Conflict level of the state
+    int depth; // Moves from the initial state
+    uint64_t hash; // Zobrist hash of the state
+    shared_ptr<const vector<uint8_t>> parent; // The parent state, row-major
+    int cell; // Cell recolored from the parent, -1 for the root
+    uint8_t color; // New color of the cell
+
+    /**
+     * @brief Returns the state, row-major.
+     */
+    vector<uint8_t> grid() const {
+        vector<uint8_t> g = *parent;
+        if (cell >= 0) g[cell] = color;
+        return g;
+    }
+
+    /**
+     * @brief Orders states by conflicts, then deeper first, so that plateaus of equal
+     * conflicts are searched depth first. Lower is better.
+     */
+    long rank() const {
+        return ((long)priority << 32) - depth;
+    }
+};
+
+/**
+ * @brief Lock-free multi-producer, single-consumer mailbox.
+ *
+ * Senders push with a compare-and-swap on the head, the owner takes every pending
+ * message at once with an exchange.
+ */
+class Mailbox {
+public:
+    atomic<Message*> head{nullptr};
+
+    void send(Message* m) {
+        m->next = head.load(memory_order_relaxed);
+        while (!head.compare_exchange_weak(m->next, m, memory_order_release, memory_order_relaxed)) {
+            ;
+        }
+    }
+
+    Message* take() {
+        return head.exchange(nullptr, memory_order_acquire);
+    }
+};
+
+/**
+ * @brief Comparison class for the local open lists: best rank first.
+ */
+class CompareMessage {
+public:
+    bool operator() (const Message* a, const Message* b) {
+        return a->rank() > b->rank();
+    }
+};
+
+/**
+ * @brief Performs a hash-distributed parallel Best-First Search (HDA*) on the given Latin square coloring problem.
+ *
+ * Every state is owned by the thread given by its hash. Each thread keeps its own open
+ * list and closed set, and sends every child it generates to the mailbox of its owner.
+ * Every thread publishes the conflicts of its best open state, and senders lower the
+ * inbound bound of the owner before the child is received. A thread only expands a
+ * state within slack conflicts of the best bound of all threads, so threads do not work
+ * through states far worse than the global best while still expanding in parallel. A
+ * goal is detected when it is generated. The search stops at the first goal, or when no
+ * state is queued or in flight.
+ *
+ * @param S The initial LSC instance to start the search from.
+ * @param p The number of threads.
+ * @param slack Extra conflicts a thread may expand above the best published state.
+ * @param print Print the solution and per-thread statistics.
+ * @param out The stream printed to.
+ * @return The number of states expanded.
+ */
+long BestFS(LSC S, int p, int slack, bool print, ostream& out)
+{
+    int x = S.square.size();
+    vector<Mailbox> mailbox(p);
+    atomic<long> outstanding(1); // States sent but not yet expanded or dropped
+    atomic<bool> found(false);
+    vector<uint8_t> solution;
+    vector<long> expanded(p, 0), received(p, 0);
+    vector<atomic<int>> frontier(p); // Conflicts of the best open state of every thread
+    vector<atomic<int>> inbound(p); // Lower bound on the conflicts of the children in flight to every thread
+    for (int t = 0; t < p; t++)
+    {
+        frontier[t] = INT_MAX;
+        inbound[t] = INT_MAX;
+    }
+
+    auto start = make_shared<vector<uint8_t>>(x * x);
+    for (int i = 0; i < x; i++)
+    {
+        for (int j = 0; j < x; j++)
+        {
+            (*start)[i * x + j] = S.square[i][j];
+        }
+    }
+    Message* root = new Message{nullptr, S.CL(), 0, S.hash, start, -1, 0};
+    mailbox[S.hash % p].send(root);
+
+    #pragma omp parallel num_threads(p)
+    {
+        int t = omp_get_thread_num();
+        priority_queue<Message*, vector<Message*>, CompareMessage> Open;
+        HashSet Close;
+        vector<vector<int>> square(x, vector<int>(x));
+
+        while (!found.load(memory_order_relaxed))
+        {
+            // Fold the inbound bound into the frontier, and reset it unless a sender lowered
+            // it meanwhile. Children sent before the reset are then drained below, so both
+            // bounds together always cover every state of the thread.
+            int in = inbound[t].load();
+            if (in < frontier[t].load(memory_order_relaxed)) frontier[t].store(in);
+            inbound[t].compare_exchange_strong(in, INT_MAX);
+
+            // Move incoming states to the open list, dropping duplicates
+            for (Message* m = mailbox[t].take(); m != nullptr;)
+            {
+                Message* next = m->next;
+                received[t]++;
+                if (Close.insert(m->hash))
+                {
+                    Open.push(m);
+                }
+                else
+                {
+                    delete m;
+                    outstanding--;
+                }
+                m = next;
+            }
+            frontier[t].store(Open.empty() ? INT_MAX : Open.top()->priority);
+            if (Open.empty())
+            {
+                if (outstanding.load() == 0) break;
+                this_thread::yield();
+                continue;
+            }
+            int best = INT_MAX;
+            for (int u = 0; u < p; u++)
+            {
+                best = min(best, min(frontier[u].load(memory_order_relaxed), inbound[u].load(memory_order_relaxed)));
+            }
+            if (Open.top()->priority > best + slack)
+            {
+                this_thread::yield(); // Other threads hold much better states
+                continue;
+            }
+
+            Message* curr = Open.top();
+            Open.pop();
+            expanded[t]++;
+            if (curr->priority == 0)
+            {
+                #pragma omp critical
+                if (!found.exchange(true)) solution = curr->grid();
+                delete curr;
+                break;
+            }
+
+            // Rebuild the counters of the state and send every child to its owner
+            shared_ptr<const vector<uint8_t>> grid = make_shared<vector<uint8_t>>(curr->grid());
+            for (int i = 0; i < x; i++)
+            {
+                for (int j = 0; j < x; j++)
+                {
+                    square[i][j] = (*grid)[i * x + j];
+                }
+            }
+            Conflicts C(square);
+            for (auto &cell : S.Cand_set)
+            {
+                int color = square[cell.first][cell.second];
+                for (int color_next = 1; color_next <= x; color_next++)
+                {
+                    if (color_next == color) continue;
+                    int priority = C.total + C.delta(cell, color, color_next);
+                    if (priority == 0)
+                    {
+                        // A goal is final as soon as it is generated, it need not wait in an open list
+                        #pragma omp critical
+                        if (!found.exchange(true))
+                        {
+                            solution = *grid;
+                            solution[cell.first * x + cell.second] = color_next;
+                        }
+                        break;
+                    }
+                    uint64_t h = curr->hash ^ zobrist(cell, color) ^ zobrist(cell, color_next);
+                    int owner = h % p;
+                    if (owner == t && Close.contains(h)) continue; // Drop known duplicates early
+                    Message* child = new Message{nullptr, priority, curr->depth + 1, h, grid, cell.first * x + cell.second, (uint8_t)color_next};
+                    outstanding++;
+                    mailbox[owner].send(child);
+                    // Let the owner's inbound bound cover the child until it is received
+                    int f = inbound[owner].load();
+                    while (priority < f && !inbound[owner].compare_exchange_weak(f, priority))
+                    {
+                        ;
+                    }
+                }
+                if (found.load(memory_order_relaxed)) break;
+            }
+            delete curr;
+            outstanding--;
+        }
+
+        // Free whatever is left
+        while (!Open.empty())
+        {
+            delete Open.top();
+            Open.pop();
+        }
+        #pragma omp barrier
+        for (Message* m = mailbox[t].take(); m != nullptr;)
+        {
+            Message* next = m->next;
+            delete m;
+            m = next;
+        }
+    }
+
+    long steps = 0;
+    for (int t = 0; t < p; t++)
+    {
+        steps += expanded[t];
+        if (print) out << "Thread " << t << ": " << expanded[t] << " expanded, " << received[t] << " received\n";
+    }
+    if (print && found)
+    {
+        for (int i = 0; i < x; i++)
+        {
+            for (int j = 0; j < x; j++)
+            {
+                out << (int)solution[i * x + j] << " ";
+            }
+            out << "\n";
+        }
+        out << "Steps taken: " << steps << "\n";
+    }
+    return steps;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 16; // Default number of threads
+    if (argc > 1)
+    {
+        num_threads = stoi(argv[1]);
+    }
+    omp_set_num_threads(num_threads);
+    string path = (argc > 2) ? argv[2] : "-"; // Instance file, stdin by default
+    int slack = 0; // Extra conflicts a thread may expand above the best published state
+    for (int i = 3; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--slack" && i + 1 < argc) slack = max(0, stoi(argv[++i]));
+        else
+        {
+            cout << "Usage: " << argv[0] << " [threads] [file] [--slack conflicts]\n";
+            return 1;
+        }
+    }
+
+    cout << "Number of threads: " << omp_get_max_threads() << ", slack: " << slack << endl;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    // Every instance already uses all threads, so instances are solved one at a time
+    long count = run_batch(path, 1, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        STATS_RESET();
+        omp_set_num_threads(num_threads); // The worker thread does not inherit the setting
+        LSC test(partial, run_seed(time(0)) + id);
+        if (!test.error.empty())
+        {
+            out << test.error;
+            return;
+        }
+        test.printSquare(out);
+        out << "\n";
+
+        // Sequential baseline: the search of the bestfs target
+        std::chrono::time_point<std::chrono::system_clock> start, end;
+        start = std::chrono::system_clock::now();
+        LSC goal;
+        long seq_steps;
+        BestFS(test, goal, seq_steps);
+        end = std::chrono::system_clock::now();
+        std::chrono::duration<double> seq_seconds = end - start;
+
+        // Start the thread team first, so that the speedup measures the search alone
+        #pragma omp parallel num_threads(num_threads)
+        {
+            ;
+        }
+        start = std::chrono::system_clock::now();
+        long par_steps = BestFS(test, num_threads, slack, true, out);
+        end = std::chrono::system_clock::now();
+        std::chrono::duration<double> elapsed_seconds = end - start;
+
+        out << "Sequential (bestfs): " << seq_steps << " steps, " << seq_seconds.count() << "s\n";
+        out << "Parallel: " << par_steps << " steps, " << elapsed_seconds.count() << "s\n";
+        out << "Speedup: " << seq_seconds.count() / elapsed_seconds.count() << "x\n";
+        out << "elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
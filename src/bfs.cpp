@@ -1,4 +1,5 @@
 #include "lsc.hpp"
+#include "io.hpp"
 
 using namespace std;
 
@@ -6,68 +7,73 @@ using namespace std;
  * @brief Performs a Breadth-First Search (BFS) on the given Latin square coloring problem.
  *
  * @param S The initial LSC instance to start the search from.
+ * @param out The stream that receives the solution.
  */
-void BFS(LSC S)
+void BFS(LSC S, ostream& out)
 {
     int steps = 0;
-    queue<LSC> Open;
-    Open.push(S);
+    vector<Node> nodes = {{-1, 0, 0, 0, 0}};
+    queue<int> Open;
+    Open.push(0);
     bool solved = false;
 
-    map<vector<vector<int>>, int> Close;
+    HashSet Close;
+    Close.insert(S.hash);
     LSC curr;
+    int curr_id = -1;
 
     while (!Open.empty())
     {
-        steps++;
-        curr = Open.front();
-        // curr.printSquare();
-        // cout << "\n";
+        int id = Open.front();
         Open.pop();
+        steps++;
+        rebuild(S, nodes, id, curr, curr_id);
+        // curr.printSquare(out);
+        // out << "\n";
         if (curr.GoalTest())
         {
             solved = true;
             break;
         }
-        Close[curr.square]++;
 
-        curr.MoveGen(Open, Close);
+        curr.MoveGen(id, nodes, Open, Close);
     }
 
-    cout << "Soln\n";
+    out << "Soln\n";
     if (solved)
     {
-        curr.printSquare();
+        curr.printSquare(out);
         return;
     }
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    LSC test(
-        // {{3, 0, 0, 0, 0},
-        //  {0, 0, 0, 2, 0},
-        //  {0, 0, 1, 0, 0},
-        //  {0, 0, 0, 0, 0},
-        //  {0, 0, 0, 1, 0},
-        // }
-        // {{1, 0, 0, 0},
-        //  {0, 0, 0, 0},
-        //  {0, 0, 0, 0},
-        //  {3, 0, 0, 0},
-        // }
-        {{3, 0, 0},
-         {0, 0, 0},
-         {1, 0, 0}}
-    );
-    test.printSquare();
-    cout << "\n";
+    string path = (argc > 1) ? argv[1] : "-"; // Instance file, stdin by default
+    int workers = (argc > 2) ? stoi(argv[2]) : thread::hardware_concurrency(); // Instances solved at once
+
     std::chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
-    BFS(test);
+    long count = run_batch(path, workers, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        STATS_RESET();
+        LSC test(partial, run_seed(time(0)) + id);
+        if (!test.error.empty())
+        {
+            out << test.error;
+            return;
+        }
+        test.printSquare(out);
+        out << "\n";
+        auto start = std::chrono::system_clock::now();
+        BFS(test, out);
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+        out << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
     end = std::chrono::system_clock::now();
 
     std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
     return 0;
 }
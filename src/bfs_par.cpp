@@ -0,0 +1,191 @@
+#include <omp.h>
+#include <atomic>
+#include <climits>
+#include "lsc.hpp"
+#include "io.hpp"
+
+using namespace std;
+
+const int SHARDS = 64; // Number of shards of the visited set
+
+/**
+ * @brief Returns the shard of the visited set that owns a state hash.
+ */
+int shard(uint64_t h)
+{
+    return (h >> 58) & (SHARDS - 1);
+}
+
+/**
+ * @brief Performs a level-synchronous parallel Breadth-First Search (BFS) on the given Latin square coloring problem.
+ *
+ * Each level is expanded in two phases. First, the frontier is split statically across
+ * threads. Every thread rebuilds its nodes and collects children whose hash is not in
+ * the visited set, bucketed by shard. Second, every shard is merged by a single thread.
+ * It walks the buckets in thread order, so children are deduplicated in (parent, move)
+ * order. The next frontier is therefore the same for any number of threads. Once a goal
+ * is found, the rest of its level is only goal-tested up to that goal, so the first goal
+ * in frontier order is reported without generating any more children.
+ *
+ * @param S The initial LSC instance to start the search from.
+ * @param out The stream that receives the per-level statistics and the solution.
+ */
+void BFS(LSC S, ostream& out)
+{
+    long steps = 0;
+    vector<Node> nodes = {{-1, 0, 0, 0, 0}};
+    vector<int> frontier = {0};
+    vector<HashSet> Close(SHARDS);
+    Close[shard(S.hash)].insert(S.hash);
+    atomic<bool> found(false);
+    atomic<int> solution(INT_MAX); // Id of the first goal in frontier order
+    int p = omp_get_max_threads();
+
+    for (int level = 0; !frontier.empty() && !found; level++)
+    {
+        auto start = chrono::system_clock::now();
+        vector<vector<vector<pair<uint64_t, Node>>>> local(p, vector<vector<pair<uint64_t, Node>>>(SHARDS));
+        long generated = 0, tested = 0;
+
+        // Expand the frontier
+        #pragma omp parallel reduction(+:generated, tested)
+        {
+            int t = omp_get_thread_num();
+            LSC curr;
+            int curr_id = -1;
+            int x = S.square.size();
+
+            #pragma omp for schedule(static)
+            for (int k = 0; k < (int)frontier.size(); k++)
+            {
+                int id = frontier[k];
+                // Once a goal is known the search ends at this level. Ids grow along the
+                // frontier, so only earlier nodes can still hold the first goal.
+                bool known = found.load(memory_order_relaxed);
+                if (known && id > solution.load(memory_order_relaxed)) continue;
+                rebuild(S, nodes, id, curr, curr_id);
+                tested++;
+                if (curr.GoalTest())
+                {
+                    int first = solution.load(memory_order_relaxed);
+                    while (id < first && !solution.compare_exchange_weak(first, id, memory_order_relaxed))
+                    {
+                        ;
+                    }
+                    found.store(true, memory_order_relaxed);
+                    continue;
+                }
+                if (known) continue; // No children are needed
+                for (auto &cell : curr.Cand_set)
+                {
+                    int color = curr.square[cell.first][cell.second];
+                    for (int color_next = 1; color_next <= x; color_next++)
+                    {
+                        if (color_next == color) continue;
+                        uint64_t h = curr.hash ^ zobrist(cell, color) ^ zobrist(cell, color_next);
+                        if (Close[shard(h)].contains(h)) continue; // Visited in an earlier level
+                        local[t][shard(h)].push_back({h, {id, (uint8_t)cell.first, (uint8_t)cell.second, (uint8_t)color, (uint8_t)color_next}});
+                        generated++;
+                    }
+                }
+            }
+        }
+        steps += tested;
+
+        if (found)
+        {
+            chrono::duration<double> secs = chrono::system_clock::now() - start;
+            out << "Level " << level << ": frontier " << frontier.size() << ", " << tested / secs.count() << " nodes/s\n";
+            break;
+        }
+
+        // Deduplicate each shard, walking the thread buckets in order
+        vector<vector<Node>> fresh(SHARDS);
+        #pragma omp parallel for schedule(dynamic)
+        for (int s = 0; s < SHARDS; s++)
+        {
+            for (int t = 0; t < p; t++)
+            {
+                for (auto &c : local[t][s])
+                {
+                    if (Close[s].insert(c.first)) fresh[s].push_back(c.second);
+                }
+            }
+        }
+
+        // Append the new nodes shard by shard
+        vector<size_t> offset(SHARDS + 1, nodes.size());
+        for (int s = 0; s < SHARDS; s++)
+        {
+            offset[s + 1] = offset[s] + fresh[s].size();
+        }
+        nodes.resize(offset[SHARDS]);
+        vector<int> next(offset[SHARDS] - offset[0]);
+        #pragma omp parallel for schedule(dynamic)
+        for (int s = 0; s < SHARDS; s++)
+        {
+            for (size_t k = 0; k < fresh[s].size(); k++)
+            {
+                nodes[offset[s] + k] = fresh[s][k];
+                next[offset[s] + k - offset[0]] = offset[s] + k;
+            }
+        }
+
+        chrono::duration<double> secs = chrono::system_clock::now() - start;
+        out << "Level " << level << ": frontier " << frontier.size() << ", generated " << generated
+             << ", new " << next.size() << ", " << frontier.size() / secs.count() << " nodes/s\n";
+        frontier.swap(next);
+    }
+
+    out << "Nodes expanded: " << steps << "\n";
+    if (!found)
+    {
+        out << "Given Partial Latin Square cannot be solved\n";
+        return;
+    }
+    out << "Soln\n";
+    LSC curr;
+    int curr_id = -1;
+    rebuild(S, nodes, solution, curr, curr_id);
+    curr.printSquare(out);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 16; // Default number of threads
+    if (argc > 1)
+    {
+        num_threads = stoi(argv[1]);
+    }
+    omp_set_num_threads(num_threads);
+    string path = (argc > 2) ? argv[2] : "-"; // Instance file, stdin by default
+
+    cout << "Number of threads: " << omp_get_max_threads() << endl;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    // Every instance already uses all threads, so instances are solved one at a time
+    long count = run_batch(path, 1, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        STATS_RESET();
+        omp_set_num_threads(num_threads); // The worker thread does not inherit the setting
+        LSC test(partial, run_seed(time(0)) + id);
+        if (!test.error.empty())
+        {
+            out << test.error;
+            return;
+        }
+        test.printSquare(out);
+        out << "\n";
+        auto start = std::chrono::system_clock::now();
+        BFS(test, out);
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+        out << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include <omp.h>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include "lsc.hpp"
+#include "io.hpp"
+
+using namespace std;
+
+/**
+ * @brief A partial square still to explore, with the domains left by its parent's filtering.
+ */
+struct Task {
+    vector<uint8_t> grid; // The partial square, row-major, 0 for an empty cell
+    Domain D; // Domain store left by the parent, without the branch on cell
+    int cell; // Cell filled by the branch that created the task, -1 for the root
+};
+
+/**
+ * @brief Work queue of one thread. The owner works at the back, thieves take from the front.
+ */
+class Worker {
+public:
+    mutex lock;
+    deque<Task> tasks; // Partial squares still to explore, shallowest first
+    long nodes = 0; // Partial squares expanded by this thread
+    long steals = 0; // Tasks taken from other threads
+    long filter_calls = 0; // Calls to the all-different filter
+    long removed = 0; // Symbols removed by the all-different filter
+    double filter_seconds = 0; // Time spent in the all-different filter
+};
+
+/**
+ * @brief Builds the domain store of a packed partial square.
+ *
+ * @param grid The partial square, row-major, 0 for an empty cell.
+ * @param x The order of the square.
+ */
+Domain domain_of(const vector<uint8_t>& grid, int x)
+{
+    Domain D(x, Domain::range(1, x));
+    for (int i = 0; i < x; i++)
+    {
+        for (int j = 0; j < x; j++)
+        {
+            if (grid[i * x + j] != 0)
+            {
+                D.clear({i, j});
+                D.place({i, j}, grid[i * x + j]);
+            }
+        }
+    }
+    return D;
+}
+
+/**
+ * @brief Propagates one partial square and branches on its most constrained empty cell.
+ *
+ * The branch is placed in the domain store inherited from the parent, and only the
+ * entries and units it touches are propagated and filtered again.
+ *
+ * @param task The partial square to expand. Cells forced by the propagation are filled in.
+ * @param x The order of the square.
+ * @param P The singles propagator of the calling thread.
+ * @param A The all-different filter of the calling thread.
+ * @param children Receives the partial squares for every symbol left in the chosen cell,
+ *                 the smallest symbol last so that it is explored first.
+ * @return true if the square is complete, false otherwise.
+ */
+bool expand(Task& task, int x, Propagator& P, AllDiff& A, vector<Task>& children)
+{
+    vector<uint8_t> &grid = task.grid;
+    vector<vector<int>> square(x, vector<int>(x));
+    for (int i = 0; i < x; i++)
+    {
+        for (int j = 0; j < x; j++)
+        {
+            square[i][j] = grid[i * x + j];
+        }
+    }
+    if (task.cell < 0)
+    {
+        A.touch_all();
+    }
+    else
+    {
+        P.branch(task.D, square, {task.cell / x, task.cell % x});
+        A.placed(task.D, square, {task.cell / x, task.cell % x});
+    }
+    vector<pair<int, int>> fixed;
+    if (!propagate(task.D, square, P, A, fixed)) return false; // Dead end
+    for (auto &v : fixed)
+    {
+        grid[v.first * x + v.second] = square[v.first][v.second];
+    }
+
+    pair<int, int> best = {-1, -1};
+    int best_size = x + 1;
+    for (int i = 0; i < x; i++)
+    {
+        for (int j = 0; j < x; j++)
+        {
+            if (grid[i * x + j] != 0) continue;
+            int size = task.D.size({i, j});
+            if (size < best_size)
+            {
+                best_size = size;
+                best = {i, j};
+            }
+        }
+    }
+    if (best.first < 0) return true; // No empty cell left
+
+    uint64_t mask = task.D.mask(best);
+    for (int color = x; color >= 1; color--)
+    {
+        if ((mask >> color) & 1)
+        {
+            children.push_back({grid, task.D, best.first * x + best.second});
+            children.back().grid[best.first * x + best.second] = color; // Placed in D by the child's expand()
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Performs a parallel backtracking Depth-First Search (DFS) with work stealing.
+ *
+ * Every thread owns a deque of partial squares. It pops its deepest task, and when its
+ * deque runs dry it steals the shallowest task of another thread, which tends to be
+ * the largest unexplored subtree. A shared flag cancels all threads once a solution is
+ * found.
+ *
+ * @param partial The partial Latin square to complete.
+ * @param out The stream that receives the statistics and the solution.
+ */
+void DFS(const vector<vector<int>>& partial, ostream& out)
+{
+    int x = partial.size();
+    int p = omp_get_max_threads();
+    vector<Worker> workers(p);
+    vector<uint8_t> root(x * x);
+    for (int i = 0; i < x; i++)
+    {
+        for (int j = 0; j < x; j++)
+        {
+            root[i * x + j] = partial[i][j];
+        }
+    }
+    workers[0].tasks.push_back({root, domain_of(root, x), -1});
+
+    atomic<long> pending(1); // Tasks pushed but not yet expanded
+    atomic<bool> found(false);
+    vector<uint8_t> solution;
+    mutex solution_lock;
+
+    #pragma omp parallel
+    {
+        int t = omp_get_thread_num();
+        Worker &self = workers[t];
+        vector<Task> children;
+        Propagator P(x);
+        AllDiff A(x);
+        unsigned int seed = t + 1;
+
+        while (!found.load(memory_order_relaxed) && pending.load() > 0)
+        {
+            Task task;
+            bool have = false;
+            {
+                lock_guard<mutex> guard(self.lock);
+                if (!self.tasks.empty())
+                {
+                    task = move(self.tasks.back());
+                    self.tasks.pop_back();
+                    have = true;
+                }
+            }
+            // Steal the shallowest task of a random victim
+            for (int k = 0; k < p && !have; k++)
+            {
+                Worker &victim = workers[(rand_r(&seed) + k) % p];
+                if (&victim == &self) continue;
+                lock_guard<mutex> guard(victim.lock);
+                if (!victim.tasks.empty())
+                {
+                    task = move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    have = true;
+                    self.steals++;
+                }
+            }
+            if (!have)
+            {
+                this_thread::yield(); // Let the busy threads push work before locking the victims again
+                continue;
+            }
+
+            self.nodes++;
+            children.clear();
+            if (expand(task, x, P, A, children))
+            {
+                lock_guard<mutex> guard(solution_lock);
+                if (!found.exchange(true)) solution = task.grid;
+            }
+            {
+                lock_guard<mutex> guard(self.lock);
+                for (auto &child : children)
+                {
+                    self.tasks.push_back(move(child));
+                }
+            }
+            pending += (long)children.size() - 1;
+        }
+        self.filter_calls = A.calls;
+        self.removed = A.removed;
+        self.filter_seconds = A.seconds;
+    }
+
+    long nodes = 0, steals = 0, filter_calls = 0, removed = 0;
+    double filter_seconds = 0;
+    for (int t = 0; t < p; t++)
+    {
+        nodes += workers[t].nodes;
+        steals += workers[t].steals;
+        filter_calls += workers[t].filter_calls;
+        removed += workers[t].removed;
+        filter_seconds += workers[t].filter_seconds;
+        out << "Thread " << t << ": " << workers[t].nodes << " nodes, " << workers[t].steals << " steals\n";
+    }
+    out << "Nodes expanded: " << nodes << ", steals: " << steals << "\n";
+    out << "All-different: " << filter_calls << " calls, " << removed << " values removed, "
+         << (filter_calls ? filter_seconds * 1e6 / filter_calls : 0) << "us per call\n";
+    if (found)
+    {
+        out << "Soln\n";
+        for (int i = 0; i < x; i++)
+        {
+            for (int j = 0; j < x; j++)
+            {
+                out << (int)solution[i * x + j] << " ";
+            }
+            out << "\n";
+        }
+    }
+    else
+    {
+        out << "Given Partial Latin Square cannot be solved\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 16; // Default number of threads
+    if (argc > 1)
+    {
+        num_threads = stoi(argv[1]);
+    }
+    omp_set_num_threads(num_threads);
+    string path = (argc > 2) ? argv[2] : "-"; // Instance file, stdin by default
+
+    cout << "Number of threads: " << omp_get_max_threads() << endl;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    // Every instance already uses all threads, so instances are solved one at a time
+    long count = run_batch(path, 1, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        STATS_RESET();
+        omp_set_num_threads(num_threads); // The worker thread does not inherit the setting
+        if ((int)partial.size() > MAX_ORDER)
+        {
+            out << "Orders above " << MAX_ORDER << " are not supported\n";
+            return;
+        }
+        auto start = std::chrono::system_clock::now();
+        DFS(partial, out);
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+        out << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
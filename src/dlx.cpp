@@ -0,0 +1,45 @@
+#include <chrono>
+#include "dlx.hpp"
+#include "io.hpp"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    string path = (argc > 1) ? argv[1] : "-"; // Instance file, stdin by default
+    int workers = (argc > 2) ? stoi(argv[2]) : thread::hardware_concurrency(); // Instances solved at once
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    long count = run_batch(path, workers, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        auto start = std::chrono::system_clock::now();
+        DLX solver(partial);
+        bool solved = solver.solve();
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+
+        if (solved)
+        {
+            out << "Soln\n";
+            for (auto &row : solver.square)
+            {
+                for (int v : row)
+                {
+                    out << v << " ";
+                }
+                out << "\n";
+            }
+        }
+        else
+        {
+            out << "Given Partial Latin Square cannot be solved\n";
+        }
+        out << "Nodes: " << solver.nodes << " (" << solver.nodes / elapsed_seconds.count() << " nodes/s)\n";
+        out << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+    });
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
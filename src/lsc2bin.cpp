@@ -0,0 +1,52 @@
+#include <chrono>
+#include "io.hpp"
+#include "corpus.hpp"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cout << "Usage: " << argv[0] << " <instance file, - for stdin> <corpus file>\n";
+        return 1;
+    }
+    string path = argv[1];
+
+    ifstream file;
+    if (path != "-")
+    {
+        file.open(path);
+        if (!file)
+        {
+            cout << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    istream& in = (path == "-") ? cin : file;
+
+    corpus::Writer out;
+    if (!out.open(argv[2]))
+    {
+        cout << "Cannot create " << argv[2] << "\n";
+        return 1;
+    }
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    vector<vector<int>> square;
+    while (read_instance(in, square))
+    {
+        out.add(square);
+    }
+    if (!in.eof())
+    {
+        cerr << "Malformed instance in " << path << ", stopping\n";
+    }
+    size_t count = out.close();
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
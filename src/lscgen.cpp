@@ -0,0 +1,128 @@
+#include <chrono>
+#include <sstream>
+#include "generate.hpp"
+#include "io.hpp"
+#include "corpus.hpp"
+
+using namespace std;
+
+/**
+ * @brief Parses a comma-separated list.
+ */
+template <class T>
+vector<T> parse_list(const string& arg)
+{
+    vector<T> res;
+    stringstream in(arg);
+    string item;
+    while (getline(in, item, ','))
+    {
+        stringstream v(item);
+        T x;
+        v >> x;
+        res.push_back(x);
+    }
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<int> orders = {10};
+    vector<double> holes = {0.42};
+    int count = 1;
+    unsigned seed = 1;
+    long moves = -1; // Markov chain moves, order^3 by default
+    bool qcp = false, binary = false;
+    string output = "-";
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) orders = parse_list<int>(argv[++i]);
+        else if (arg == "-h" && i + 1 < argc) holes = parse_list<double>(argv[++i]);
+        else if (arg == "-k" && i + 1 < argc) count = stoi(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc) seed = stoul(argv[++i]);
+        else if (arg == "-m" && i + 1 < argc) moves = stol(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--qcp") qcp = true;
+        else if (arg == "-b") binary = true;
+        else
+        {
+            cout << "Usage: " << argv[0] << " [-n orders] [-h hole ratios] [-k instances each] [-s seed] [-m moves] [--qcp] [-b] [-o file]\n";
+            return 1;
+        }
+    }
+    const int MAX_GEN_ORDER = 255; // Keeps the n^3 byte cube of the generator within 16 MB
+    for (int n : orders)
+    {
+        if (n < 1 || n > MAX_GEN_ORDER)
+        {
+            cout << "Orders must be between 1 and " << MAX_GEN_ORDER << "\n";
+            return 1;
+        }
+    }
+    if (binary && output == "-")
+    {
+        cout << "A binary corpus needs an output file\n";
+        return 1;
+    }
+
+    ofstream file;
+    corpus::Writer writer;
+    bool created = true;
+    if (binary)
+    {
+        created = writer.open(output);
+    }
+    else if (output != "-")
+    {
+        file.open(output);
+        created = bool(file);
+    }
+    if (!created)
+    {
+        cout << "Cannot create " << output << "\n";
+        return 1;
+    }
+    ostream& out = (output == "-") ? cout : file;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    long total = 0;
+    for (int n : orders)
+    {
+        for (size_t h = 0; h < holes.size(); h++)
+        {
+            for (int k = 0; k < count; k++)
+            {
+                // Every instance has a stream of its own, so it does not depend on the other lists
+                Generator gen({seed, (uint32_t)n, (uint32_t)(holes[h] * 1e6), (uint32_t)k, qcp});
+                vector<vector<int>> square;
+                if (qcp)
+                {
+                    square = gen.qcp(n, holes[h]);
+                }
+                else
+                {
+                    square = gen.latin_square(n, moves >= 0 ? moves : (long)n * n * n);
+                    gen.qwh(square, holes[h]);
+                }
+                if (binary)
+                {
+                    writer.add(square);
+                }
+                else
+                {
+                    out << "# " << (qcp ? "qcp" : "qwh") << " order " << n << " holes " << holes[h] << " seed " << seed << " index " << k << "\n";
+                    write_instance(out, square);
+                }
+                total++;
+            }
+        }
+    }
+    if (binary) writer.close();
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    cerr << "Instances: " << total << ", elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
@@ -0,0 +1,419 @@
+#include <omp.h>
+#include <atomic>
+#include "plits.hpp"
+#include "io.hpp"
+
+using namespace std;
+
+/**
+ * @brief A member of the memetic population: a colouring of every free cell.
+ */
+struct Individual {
+    LSC S; // The colouring
+    vector<uint8_t> colors; // Colour of every cell of Cand_set, in order, 0 if empty
+    int cost = 0; // F(1) of the colouring: empty cells plus conflicts
+
+    /**
+     * @brief Refreshes colors and cost from S.
+     */
+    void sync() {
+        colors.resize(S.Cand_set.size());
+        for (size_t k = 0; k < S.Cand_set.size(); k++) {
+            colors[k] = S.square[S.Cand_set[k].first][S.Cand_set[k].second];
+        }
+        cost = S.F(1);
+    }
+
+    /**
+     * @brief Checks if the colouring completes the square.
+     */
+    bool solved() {
+        return S.count_zero() == 0 && S.CL() == 0;
+    }
+};
+
+/**
+ * @brief The symbols left to every cell of Cand_set by the preprocessing.
+ */
+vector<vector<uint8_t>> domains(const LSC& root)
+{
+    int x = root.square.size();
+    vector<vector<uint8_t>> res(root.Cand_set.size());
+    for (size_t k = 0; k < root.Cand_set.size(); k++)
+    {
+        for (int c = 1; c <= x; c++)
+        {
+            if (root.D.contains(root.Cand_set[k], c)) res[k].push_back(c);
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Counts the free cells two individuals colour differently.
+ */
+int distance(const Individual& a, const Individual& b)
+{
+    int res = 0;
+    for (size_t k = 0; k < a.colors.size(); k++) res += a.colors[k] != b.colors[k];
+    return res;
+}
+
+/**
+ * @brief Improves a colouring in place with tabu search.
+ *
+ * Minimises F(1), the empty cells plus the conflicts. As in the tabu search of Jin &
+ * Hao, only empty cells and cells in conflict are recoloured, each time with the best
+ * non-tabu move to a symbol of its domain (or a tabu one leading to a new best), ties
+ * broken at random. A recoloured cell may not take its old colour back for
+ * rand(10) + 0.6 F(1) iterations. The best colouring is kept as the colours of the free
+ * cells and restored at the end, so the colour classes are never copied.
+ *
+ * @param S The colouring to improve.
+ * @param domain The symbols of every free cell.
+ * @param depth The number of iterations without improvement to stop after.
+ * @param rng The random generator of the search.
+ * @return The number of iterations done.
+ */
+long improve(LSC& S, const vector<vector<uint8_t>>& domain, long depth, mt19937& rng)
+{
+    int x = S.square.size();
+    TabuList tabu(x);
+    vector<uint8_t> best(S.Cand_set.size());
+    auto save = [&]() {
+        for (size_t k = 0; k < S.Cand_set.size(); k++) best[k] = S.square[S.Cand_set[k].first][S.Cand_set[k].second];
+    };
+    save();
+    int curr_F = S.F(1), best_F = curr_F;
+    long i = 0, improved = 0;
+    while (i - improved < depth && best_F > S.l) // The cells without a symbol stay empty
+    {
+        pair<int, int> cell;
+        int color = 0, best_delta = 0, ties = 0;
+        for (size_t k = 0; k < S.Cand_set.size(); k++)
+        {
+            auto& v = S.Cand_set[k];
+            int curr = S.square[v.first][v.second];
+            if (curr != 0 && S.C.at(v, curr) <= 2) continue; // Coloured without conflict
+            for (int c : domain[k])
+            {
+                if (c == curr) continue;
+                STATS_COUNT(NEIGHBOURS);
+                int d = S.C.delta(v, curr, c) - (curr == 0);
+                if (color != 0 && d > best_delta) continue;
+                if (tabu.is_tabu(v, c, i) && curr_F + d >= best_F)
+                {
+                    STATS_COUNT(TABU_REJECTED);
+                    continue; // Tabu unless it aspires
+                }
+                if (color != 0 && d == best_delta)
+                {
+                    if (rng() % ++ties != 0) continue;
+                }
+                else
+                {
+                    ties = 1;
+                }
+                best_delta = d;
+                cell = v;
+                color = c;
+            }
+        }
+        if (color == 0) break; // Every move is tabu
+        int old_color = S.square[cell.first][cell.second];
+        S.Move(cell, old_color, color);
+        curr_F += best_delta;
+        i++;
+        tabu.add(cell, old_color, i + rng() % 10 + 0.6 * curr_F);
+        if (curr_F < best_F)
+        {
+            best_F = curr_F;
+            improved = i;
+            save();
+        }
+    }
+    // Back to the best colouring
+    for (size_t k = 0; k < S.Cand_set.size(); k++)
+    {
+        auto& v = S.Cand_set[k];
+        if (S.square[v.first][v.second] != best[k]) S.Move(v, S.square[v.first][v.second], best[k]);
+    }
+    return i;
+}
+
+/**
+ * @brief Colour-class preserving crossover of Jin & Hao for LSC.
+ *
+ * The parents take turns to hand down a whole colour class: the parent in turn picks the
+ * colour not handed down yet whose class holds the most free cells that are still
+ * uncoloured in the child, and the child takes the colour on all of them. Symbols are
+ * fixed by the given cells of the square, so a class keeps its colour. The cells left
+ * over get the symbol of their domain with the fewest conflicts, ties broken at random.
+ *
+ * @param root The instance, with every free cell uncoloured.
+ * @param domain The symbols of every free cell.
+ * @param a The first parent.
+ * @param b The second parent.
+ * @param rng The random generator of the offspring.
+ * @return The offspring.
+ */
+Individual crossover(const LSC& root, const vector<vector<uint8_t>>& domain, const Individual& a, const Individual& b, mt19937& rng)
+{
+    int x = root.square.size();
+    size_t m = root.Cand_set.size();
+    const Individual* parent[2] = {&a, &b};
+
+    // Uncoloured cells of every class of both parents
+    vector<int> count[2] = {vector<int>(x + 1, 0), vector<int>(x + 1, 0)};
+    for (int p = 0; p < 2; p++) {
+        for (size_t k = 0; k < m; k++) count[p][parent[p]->colors[k]]++;
+    }
+    vector<uint8_t> child(m, 0);
+    vector<char> handed(x + 1, 0);
+    size_t colored = 0;
+    for (int step = 0; step < x && colored < m; step++)
+    {
+        int p = step % 2;
+        int c = 0;
+        for (int k = 1; k <= x; k++)
+        {
+            if (!handed[k] && (c == 0 || count[p][k] > count[p][c])) c = k;
+        }
+        handed[c] = 1;
+        for (size_t k = 0; k < m; k++)
+        {
+            if (child[k] != 0 || parent[p]->colors[k] != c) continue;
+            child[k] = c;
+            colored++;
+            count[0][a.colors[k]]--;
+            count[1][b.colors[k]]--;
+        }
+    }
+
+    Individual res;
+    res.S = root;
+    LSC& S = res.S;
+    auto assign = [&](pair<int, int> v, int c) {
+        S.V[c].insert(v);
+        S.square[v.first][v.second] = c;
+        S.C.add(v, c);
+        S.hash ^= zobrist(v, c);
+    };
+    for (size_t k = 0; k < m; k++)
+    {
+        if (child[k] != 0) assign(root.Cand_set[k], child[k]);
+    }
+    for (size_t k = 0; k < m; k++)
+    {
+        if (child[k] != 0) continue;
+        auto& v = root.Cand_set[k];
+        int best = 0, ties = 0;
+        for (int c : domain[k])
+        {
+            if (best != 0 && S.C.at(v, c) > S.C.at(v, best)) continue;
+            if (best != 0 && S.C.at(v, c) == S.C.at(v, best))
+            {
+                if (rng() % ++ties != 0) continue;
+            }
+            else
+            {
+                ties = 1;
+            }
+            best = c;
+        }
+        assign(v, best);
+    }
+    res.sync();
+    return res;
+}
+
+/**
+ * @brief Distance-and-quality pool update of Lü & Hao.
+ *
+ * The offspring joins the pool, and the member with the lowest score
+ * 0.6 * quality + 0.4 * distance leaves it. Both terms are normalised over the pool;
+ * quality is a lower cost, distance the one to the closest other member. An
+ * offspring equal to a member is dropped at once.
+ *
+ * @param pool The population.
+ * @param child The offspring.
+ * @return true if the offspring stayed in the pool.
+ */
+bool update_pool(vector<Individual>& pool, Individual& child)
+{
+    const double BETA = 0.6;
+    int p = pool.size();
+    vector<int> closest(p + 1, INT32_MAX);
+    for (int i = 0; i < p; i++)
+    {
+        int d = distance(pool[i], child);
+        if (d == 0) return false; // A clone
+        closest[i] = d;
+        closest[p] = min(closest[p], d);
+    }
+    for (int i = 0; i < p; i++)
+    {
+        for (int j = i + 1; j < p; j++)
+        {
+            int d = distance(pool[i], pool[j]);
+            closest[i] = min(closest[i], d);
+            closest[j] = min(closest[j], d);
+        }
+    }
+    auto quality = [&](int i) { return i == p ? child.cost : pool[i].cost; };
+    int f_min = INT32_MAX, f_max = 0, d_min = INT32_MAX, d_max = 0;
+    for (int i = 0; i <= p; i++)
+    {
+        f_min = min(f_min, quality(i));
+        f_max = max(f_max, quality(i));
+        d_min = min(d_min, closest[i]);
+        d_max = max(d_max, closest[i]);
+    }
+    int worst = p;
+    double worst_score = 2;
+    for (int i = 0; i <= p; i++)
+    {
+        double score = BETA * (f_max - quality(i)) / (f_max - f_min + 1) + (1 - BETA) * (closest[i] - d_min) / (d_max - d_min + 1);
+        if (score < worst_score)
+        {
+            worst_score = score;
+            worst = i;
+        }
+    }
+    if (worst == p) return false;
+    pool[worst] = move(child);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 16; // Default number of threads
+    if (argc > 1)
+    {
+        num_threads = stoi(argv[1]);
+    }
+    omp_set_num_threads(num_threads);
+    string path = (argc > 2) ? argv[2] : "-"; // Instance file, stdin by default
+    int pool_size = 20; // Population size
+    int offspring = num_threads; // Offspring per generation, improved in parallel
+    long depth = 10000; // Tabu iterations per offspring
+    long generations = 1000; // Generation limit
+    for (int i = 3; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--pool" && i + 1 < argc) pool_size = stoi(argv[++i]);
+        else if (arg == "--offspring" && i + 1 < argc) offspring = stoi(argv[++i]);
+        else if (arg == "--depth" && i + 1 < argc) depth = stol(argv[++i]);
+        else if (arg == "--generations" && i + 1 < argc) generations = stol(argv[++i]);
+        else
+        {
+            cout << "Usage: " << argv[0] << " [threads] [file] [--pool p] [--offspring k] [--depth iterations] [--generations g]\n";
+            return 1;
+        }
+    }
+    if (pool_size < 2 || offspring < 1 || depth < 1)
+    {
+        cout << "The pool needs two members, and offspring and depth must be positive\n";
+        return 1;
+    }
+    unsigned seed = run_seed(time(0));
+
+    cout << "Number of threads: " << omp_get_max_threads() << ", pool: " << pool_size << ", offspring: " << offspring << ", depth: " << depth << endl;
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    // Every instance already uses all threads, so instances are solved one at a time
+    long count = run_batch(path, 1, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        STATS_RESET();
+        omp_set_num_threads(num_threads);
+        LSC test(partial);
+        if (!test.error.empty())
+        {
+            out << test.error;
+            return;
+        }
+        auto start = std::chrono::system_clock::now();
+        vector<vector<uint8_t>> domain = domains(test);
+
+        // Initial population: random colourings improved by tabu search
+        vector<LSC> starts = test.gen_population(pool_size, seed + id);
+        vector<Individual> pool(pool_size);
+        long steps = 0;
+        atomic<bool> found(false);
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+:steps)
+        for (int i = 0; i < pool_size; i++)
+        {
+            mt19937 rng(seed + id + i * 7919);
+            pool[i].S = starts[i];
+            if (!found.load(memory_order_relaxed)) steps += improve(pool[i].S, domain, depth, rng);
+            pool[i].sync();
+            if (pool[i].solved()) found.store(true, memory_order_relaxed);
+        }
+
+        int solution = -1;
+        for (int i = 0; i < pool_size && solution < 0; i++)
+        {
+            if (pool[i].solved()) solution = i;
+        }
+
+        long gen = 0;
+        vector<Individual> children(offspring);
+        for (; gen < generations && solution < 0; gen++)
+        {
+            atomic<bool> solved(false);
+            #pragma omp parallel for schedule(dynamic, 1) reduction(+:steps)
+            for (int c = 0; c < offspring; c++)
+            {
+                if (solved.load(memory_order_relaxed)) continue;
+                mt19937 rng(seed + id + (pool_size + gen * offspring + c) * 7919); // Reproducible whatever the thread
+                int a = rng() % pool_size, b = rng() % (pool_size - 1);
+                if (b >= a) b++;
+                children[c] = crossover(test, domain, pool[a], pool[b], rng);
+                steps += improve(children[c].S, domain, depth, rng);
+                children[c].sync();
+                if (children[c].solved()) solved.store(true, memory_order_relaxed);
+            }
+            for (int c = 0; c < offspring && solution < 0; c++)
+            {
+                if (children[c].colors.empty()) continue; // Skipped after a solution
+                if (children[c].solved())
+                {
+                    pool[0] = move(children[c]);
+                    solution = 0;
+                }
+                else
+                {
+                    update_pool(pool, children[c]);
+                }
+            }
+            for (auto& child : children) child = Individual();
+        }
+
+        int best = 0;
+        for (int i = 1; i < pool_size; i++)
+        {
+            if (pool[i].cost < pool[best].cost) best = i;
+        }
+        if (solution >= 0)
+        {
+            out << "Solution: \n";
+            printSquare(pool[solution].S.square, out);
+        }
+        else
+        {
+            out << "No solution, best has " << pool[best].S.f() << " empty cells and " << pool[best].S.CL() << " conflicts\n";
+        }
+
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+        out << "Generations: " << gen << "\n";
+        out << "Steps taken: " << steps << "\n";
+        out << "elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}
@@ -7,70 +7,28 @@
 #include <chrono>
 #include <ctime>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <omp.h>
+#include "domain.hpp"
+#include "graph.hpp"
+#include "propagate.hpp"
+#include "alldiff.hpp"
+#include "seed.hpp"
+#include "stats.hpp"
+#include "io.hpp"
 
 using namespace std;
 
-class Compare;
-
-/**
- * @brief Searches for an element in a vector.
- *
- * @tparam T Type of elements in the vector.
- * @param v The vector to search in.
- * @param e The element to find.
- * @return true if the element is found, false otherwise.
- */
-template <typename T>
-bool find(vector<T>& v, T e) {
-    for (auto& It: v) {
-        if (It == e) return true; // Check if the element exists
-    }
-    return false; // Element not found
-}
-
-/**
- * @brief Represents a graph using an adjacency list.
- */
-class Graph {
-public:
-    int n; // Number of vertices
-    map<pair<int, int>, vector<pair<int, int>>> adj_list; // Adjacency list
-
-    /**
-     * @brief Adds an edge between two vertices.
-     *
-     * @param n1 The first vertex.
-     * @param n2 The second vertex.
-     */
-    void add_edge(pair<int, int> n1, pair<int, int> n2) {
-        adj_list[n1].push_back(n2); // Add n2 to n1's adjacency list
-        adj_list[n2].push_back(n1); // Add n1 to n2's adjacency list
-    }
-
-    /**
-     * @brief Prints the graph's adjacency list.
-     */
-    void print_graph() {
-        for (auto& x: adj_list) {
-            cout << "(" << x.first.first << ", " << x.first.second << ")" << ": ";
-            for (auto y: x.second) {
-                cout << "(" << y.first << ", " << y.second << ")" << " ";
-            }
-            cout << "\r\n"; // New line after each vertex
-        }
-    }
-};
-
 /**
  * @brief Represents a Latin square coloring problem using graph coloring.
  */
 class LSC : public Graph {
 public:
     vector<vector<int>> square; // Latin square representation
-    map<pair<int, int>, set<int>> D; // Domain set for each cell
-    map<int, set<pair<int, int>>> V; // Color classes
+    Domain D; // Domain set for each cell
     vector<pair<int, int>> Cand_set; // Candidate cells to color
+    string error; // Why the instance was rejected, empty if it is usable
 
     /**
      * @brief Default constructor.
@@ -85,22 +43,25 @@ public:
      * @param partial The initial partial Latin square.
      */
     LSC(vector<vector<int>> partial) {
+        STATS_PHASE(PREPROCESS);
         int x = partial.size(); // Size of the square
         n = x * x; // Total number of cells
         square = partial; // Set the square
+        if (x > MAX_ORDER) {
+            error = "Orders above " + to_string(MAX_ORDER) + " are not supported\n";
+            return;
+        }
+        D = Domain(x, Domain::range(1, x)); // Initialize domain set for empty cells
 
-        // Build adjacency list and initialize candidate set
+        order = x; // The constraint graph is implied by the order
+
+        // Initialize candidate set
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
-                for (int k = j + 1; k < x; k++) {
-                    add_edge({i, j}, {i, k}); // Add horizontal edges
-                    add_edge({j, i}, {k, i}); // Add vertical edges
-                }
                 if (square[i][j] == 0) {
                     Cand_set.push_back({i, j}); // Add empty cells to candidate set
-                    for (int k = 1; k <= x; k++) {
-                        D[{i, j}].insert(k); // Initialize domain set for empty cells
-                    }
+                } else {
+                    D.clear({i, j}); // Filled cells have no domain
                 }
             }
         }
@@ -109,252 +70,469 @@ public:
         for (int i = 0; i < x; i++) {
             for (int j = 0; j < x; j++) {
                 if (square[i][j] != 0) {
-                    for (auto It : adj_list[{i, j}]) {
-                        D[It].erase(square[i][j]); // Remove filled color from adjacent cells
-                    }
-                    V[square[i][j]].insert({i, j}); // Assign the filled color
+                    D.place({i, j}, square[i][j]); // Remove filled color from adjacent cells
                 }
             }
         }
 
-        // Reduce domain set using smart solving
-        bool isReducible = true;
-        while (isReducible) {
-            isReducible = false;
-            for (int i = 0; i < x; i++) {
-                for (int j = 0; j < x; j++) {
-                    // Only one possible color can be assigned
-                    if (D[{i, j}].size() == 1) {
-                        int color = *D[{i, j}].begin(); // Get the only color
-                        V[color].insert({i, j}); // Assign color to the cell
-                        D[{i, j}].erase(color); // Remove color from the domain
-                        square[i][j] = color; // Update the square
-                        for (auto It : adj_list[{i, j}]) {
-                            D[It].erase(color); // Update adjacent cells' domains
-                        }
-                        isReducible = true; // Continue reducing
-                        pair<int, int> n1 = {i, j};
-                        // Remove the cell from the candidate set
-                        Cand_set.erase(remove(Cand_set.begin(), Cand_set.end(), n1), Cand_set.end());
-                    }
-                }
-            }
+        // Reduce domain set with singles and all-different filtering
+        Propagator P(x);
+        AllDiff A(x);
+        vector<pair<int, int>> fixed;
+        if (!propagate(D, square, P, A, fixed)) {
+            error = "Given Partial Latin Square cannot be solved\n";
+            return;
         }
+        // Remove the fixed cells from the candidate set
+        Cand_set.erase(remove_if(Cand_set.begin(), Cand_set.end(), [&](const pair<int, int>& v) {
+            return square[v.first][v.second] != 0;
+        }), Cand_set.end());
     }
 
-    void gen_solns() {
-        vector<pair<int, int>> temp_set(Cand_set.begin(), Cand_set.end());
-        std::random_device r;
-        std::mt19937 eng(r());
-        shuffle(temp_set.begin(), temp_set.end(), eng);
-
-        vector<set<pair<int, int>>> MISSets;
-        set<pair<int, int>> S;
-
-        // Generate MIS sets with size limit n
-        while (!temp_set.empty()) {
-            for (auto& cell : temp_set) {
-                if (S.size() == square.size()) break; // Restrict MIS size to n
-                bool isIndependent = true;
-
-                // Check if cell is independent
-                for (auto& selected : S) {
-                    if (find(adj_list[selected], cell)) {
-                        isIndependent = false;
-                        break;
-                    }
-                }
-                if (isIndependent) {
-                    S.insert(cell);
-                }
+    /**
+     * @brief Prints the current state of the Latin square.
+     */
+    void printSquare(ostream& out = cout) const {
+        out << "\n";
+        int x = square.size();
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) {
+                out << square[i][j] << " "; // Print each element
             }
+            out << "\n"; // New line after each row
+        }
+        out << "\n";
+    }
+};
 
-            // Remove selected cells from temp_set
-            for (auto& cell : S) {
-                temp_set.erase(remove(temp_set.begin(), temp_set.end(), cell), temp_set.end());
-            }
-            MISSets.push_back(S);
-            S.clear();
+/**
+ * @brief Flat copy of the preprocessed root state, shared read-only by every attempt.
+ */
+struct Snapshot {
+    int x = 0; // Order of the square
+    Domain D; // Domains after preprocessing
+    vector<uint8_t> grid; // Symbols in row-major order, 0 for a free cell
+    vector<int> free; // Free cells, as i * x + j
+
+    Snapshot(const LSC& S) : x(S.square.size()), D(S.D), grid(x * x) {
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) grid[i * x + j] = S.square[i][j];
         }
+        for (auto& v : S.Cand_set) free.push_back(v.first * x + v.second);
+    }
+};
 
-        // Assign colors to each MIS
-        for (auto& mis : MISSets) {
-            for (auto& cell : mis) {
-                for (int color : D[cell]) {
-                    bool isValid = true;
-
-                    // Check constraints (row and column)
-                    for (auto& neighbor : adj_list[cell]) {
-                        if (square[neighbor.first][neighbor.second] == color) {
-                            isValid = false;
-                            break;
+/**
+ * @brief Scratch state of one attempt thread.
+ *
+ * Every buffer is sized for the snapshot on construction, so restore() and gen_solns()
+ * allocate nothing; an attempt starts from a plain copy of the snapshot.
+ */
+class Attempt {
+public:
+    Domain D; // Live domains
+    vector<uint8_t> grid; // Symbols in row-major order
+
+    /**
+     * @brief Creates the scratch of a thread.
+     *
+     * @param root The snapshot to start every attempt from.
+     * @param threads The threads extracting each set.
+     */
+    Attempt(const Snapshot& root, int threads) : D(root.D), grid(root.grid), root(root), threads(threads) {
+        int x = root.x, m = root.free.size();
+        prio.assign(x * x, 0);
+        for (auto* v : {&remaining, &undecided, &next, &mis, &sequence}) v->reserve(m);
+        row_max.assign(x, 0);
+        col_max.assign(x, 0);
+        row_taken.assign(x, 0);
+        col_taken.assign(x, 0);
+        in_mis.assign(x * x, 0);
+        my_row.assign(threads, vector<uint64_t>(x));
+        my_col.assign(threads, vector<uint64_t>(x));
+        mine.assign(threads, vector<int>());
+        for (auto& v : mine) v.reserve(m);
+        buckets.assign(x + 1, vector<int>());
+        for (auto& b : buckets) b.reserve(m);
+        pos.assign(x * x, 0);
+        bucket_of.assign(x * x, -1);
+        std::random_device r;
+        seed = run_seed(r());
+    }
+
+    /**
+     * @brief Resets the state to the snapshot. The sizes match, so this only copies.
+     */
+    void restore() {
+        D = root.D;
+        grid = root.grid;
+    }
+
+    /**
+     * @brief Colours the free cells with randomised maximal independent sets.
+     *
+     * Every free cell gets a random priority. Each independent set is extracted from
+     * the cells not yet in a set with Luby / Jones-Plassmann rounds: a cell whose
+     * priority is the largest of the undecided cells of its row and column joins the set,
+     * and its row and column are dropped from the round. This yields the same set as a
+     * greedy pass in priority order, but a round costs O(|V| / p + n) on p threads, since
+     * the rook graph only needs the row and column maxima. The cells are then coloured
+     * set by set with their smallest live color.
+     *
+     * @param stream Distinguishes the attempts of a run when LSC_SEED fixes the seed.
+     * @param cancel If set, abandons the attempt, leaving the square incomplete, once it is true.
+     */
+    void gen_solns(unsigned stream, const atomic<bool>* cancel = nullptr) {
+        int x = root.x;
+        uint64_t salt = mix(seed + mix(stream));
+
+        // Priorities are unique, as the low bits hold the cell index (x * x < 4096)
+        remaining.clear();
+        for (int id : root.free) {
+            prio[id] = (mix(salt + id) << 12) | id;
+            in_mis[id] = 0;
+            remaining.push_back(id);
+        }
+        sequence.clear(); // The sets, one after the other
+        bool stop = false;
+
+        # pragma omp parallel num_threads(threads) if(threads > 1)
+        {
+            int t = omp_get_thread_num(), p = omp_get_num_threads();
+
+            // Appends the cells of src that satisfy keep to dst, in the order of src. Static
+            // chunks go to the threads in order, so the buffers are joined at prefix sums
+            // of their sizes without a lock, and the result does not depend on timing.
+            auto filter = [&](const vector<int>& src, vector<int>& dst, auto keep) {
+                mine[t].clear();
+                # pragma omp for schedule(static) nowait
+                for (size_t k = 0; k < src.size(); k++) {
+                    if (keep(src[k])) mine[t].push_back(src[k]);
+                }
+                # pragma omp barrier
+                size_t total = 0, offset = 0;
+                for (int u = 0; u < p; u++) {
+                    if (u < t) offset += mine[u].size();
+                    total += mine[u].size();
+                }
+                # pragma omp single
+                dst.resize(dst.size() + total);
+                copy(mine[t].begin(), mine[t].end(), dst.end() - total + offset);
+                # pragma omp barrier
+            };
+
+            while (!remaining.empty()) {
+                # pragma omp single
+                {
+                    stop = cancel != nullptr && cancel->load(memory_order_relaxed);
+                    STATS_COUNT(MIS_ROUNDS);
+                    undecided = remaining;
+                    mis.clear();
+                    fill(row_taken.begin(), row_taken.end(), 0);
+                    fill(col_taken.begin(), col_taken.end(), 0);
+                }
+                if (stop) break; // Read by one thread, so the whole team leaves
+
+                while (!undecided.empty()) {
+                    // Largest priority of the undecided cells of every row and column
+                    fill(my_row[t].begin(), my_row[t].end(), 0);
+                    fill(my_col[t].begin(), my_col[t].end(), 0);
+                    # pragma omp for nowait
+                    for (size_t k = 0; k < undecided.size(); k++) {
+                        int id = undecided[k];
+                        my_row[t][id / x] = max(my_row[t][id / x], prio[id]);
+                        my_col[t][id % x] = max(my_col[t][id % x], prio[id]);
+                    }
+                    # pragma omp barrier
+                    # pragma omp for
+                    for (int k = 0; k < x; k++) {
+                        row_max[k] = col_max[k] = 0;
+                        for (int u = 0; u < p; u++) {
+                            row_max[k] = max(row_max[k], my_row[u][k]);
+                            col_max[k] = max(col_max[k], my_col[u][k]);
                         }
                     }
 
-                    if (isValid) {
-                        // Assign color and update neighbors
-                        square[cell.first][cell.second] = color;
-                        V[color].insert(cell);
-                        for (auto& neighbor : adj_list[cell]) {
-                            D[neighbor].erase(color);
-                        }
-                        break;
+                    // Local maxima join the set; they never share a row or column
+                    filter(undecided, mis, [&](int id) {
+                        return prio[id] == row_max[id / x] && prio[id] == col_max[id % x];
+                    });
+                    # pragma omp for
+                    for (size_t k = 0; k < mis.size(); k++) {
+                        row_taken[mis[k] / x] = col_taken[mis[k] % x] = 1;
                     }
+
+                    // Their rows and columns leave the round
+                    # pragma omp single
+                    next.clear();
+                    filter(undecided, next, [&](int id) {
+                        return !row_taken[id / x] && !col_taken[id % x];
+                    });
+                    # pragma omp single
+                    swap(undecided, next);
+                }
+
+                # pragma omp for
+                for (size_t k = 0; k < mis.size(); k++) in_mis[mis[k]] = 1;
+                # pragma omp single
+                {
+                    sequence.insert(sequence.end(), mis.begin(), mis.end());
+                    next.clear();
                 }
+                filter(remaining, next, [&](int id) { return !in_mis[id]; });
+                # pragma omp single
+                swap(remaining, next);
+            }
+        }
+        if (stop) return;
 
-                // Remove the cell from Cand_set
-                temp_set.erase(remove(temp_set.begin(), temp_set.end(), cell), temp_set.end());
+        // Assign colors to each MIS
+        for (int id : sequence) {
+            pair<int, int> cell = {id / x, id % x};
+            // The live domain already excludes every color used in the row and column
+            if (D.size(cell) != 0) {
+                int color = D.first(cell);
+                // Assign color and update neighbors
+                grid[id] = color;
+                D.place(cell, color);
             }
         }
     }
 
-    int count_zero() {
-        int res = 0;
-        for (int i=0; i<square.size(); i++) {
-            for (int j=0; j<square.size(); j++) {
-                if (square[i][j] == 0) res++;
+    /**
+     * @brief Colours the free cells one by one, most constrained first (DSATUR).
+     *
+     * In a Latin square the saturation of a cell is the number of symbols its row and
+     * column exclude, so the next cell is one with the fewest live symbols. Cells sit in
+     * buckets by live domain size; the next cell is drawn at random from the smallest
+     * non-empty bucket and gets a random live symbol. Placing it moves the cells of its
+     * row and column that lose the symbol one bucket down. The attempt stops at the first
+     * cell left without a symbol, so a failed attempt is cheap.
+     *
+     * @param stream Distinguishes the attempts of a run when LSC_SEED fixes the seed.
+     * @param cancel If set, abandons the attempt, leaving the square incomplete, once it is true.
+     */
+    void gen_dsatur(unsigned stream, const atomic<bool>* cancel = nullptr) {
+        int x = root.x;
+        uint64_t state = mix(seed + mix(stream));
+        auto below = [&](int n) {
+            state = mix(state);
+            return (int)(state % n);
+        };
+        auto push = [&](int id, int b) {
+            bucket_of[id] = b;
+            pos[id] = buckets[b].size();
+            buckets[b].push_back(id);
+        };
+        auto pop = [&](int id) {
+            auto& b = buckets[bucket_of[id]];
+            pos[b.back()] = pos[id];
+            b[pos[id]] = b.back();
+            b.pop_back();
+            bucket_of[id] = -1;
+        };
+
+        for (auto& b : buckets) b.clear();
+        for (int id : root.free) push(id, D.size({id / x, id % x}));
+
+        for (size_t k = 0; k < root.free.size(); k++) {
+            if (cancel != nullptr && cancel->load(memory_order_relaxed)) return;
+            if (!buckets[0].empty()) return; // A cell has no symbol left
+            int b = 1;
+            while (buckets[b].empty()) b++;
+            int id = buckets[b][below(buckets[b].size())];
+            pair<int, int> cell = {id / x, id % x};
+            int color = D.kth(cell, below(b));
+            pop(id);
+            grid[id] = color;
+            D.place(cell, color);
+
+            // The free cells of the row and column that lost the symbol
+            for (int t = 0; t < x; t++) {
+                for (int nid : {cell.first * x + t, t * x + cell.second}) {
+                    if (bucket_of[nid] < 0) continue;
+                    int size = D.size({nid / x, nid % x});
+                    if (size != bucket_of[nid]) {
+                        pop(nid);
+                        push(nid, size);
+                    }
+                }
             }
         }
+    }
 
-        return res;
+    int count_zero() const {
+        return count(grid.begin(), grid.end(), 0);
     }
 
     /**
-     * @brief Prints the current state of the Latin square.
+     * @brief Returns the current square.
      */
-    void printSquare() const {
-        cout << "\n";
-        int x = square.size();
+    vector<vector<int>> square() const {
+        int x = root.x;
+        vector<vector<int>> res(x, vector<int>(x));
         for (int i = 0; i < x; i++) {
-            for (int j = 0; j < x; j++) {
-                cout << square[i][j] << " "; // Print each element
-            }
-            cout << "\n"; // New line after each row
+            for (int j = 0; j < x; j++) res[i][j] = grid[i * x + j];
         }
-        cout << "\n";
+        return res;
+    }
+
+private:
+    const Snapshot& root;
+    int threads;
+    uint64_t seed; // Base seed of the thread
+    vector<uint64_t> prio; // Priority of every free cell
+    vector<int> remaining, undecided, next, mis, sequence;
+    vector<uint64_t> row_max, col_max;
+    vector<char> row_taken, col_taken, in_mis;
+    vector<vector<uint64_t>> my_row, my_col; // Per-thread maxima
+    vector<vector<int>> mine; // Per-thread filter output
+    vector<vector<int>> buckets; // Queued cells by live domain size
+    vector<int> pos, bucket_of; // Position and bucket of every queued cell, bucket -1 once coloured
+
+    /**
+     * @brief The splitmix64 finaliser.
+     */
+    static uint64_t mix(uint64_t z) {
+        z += 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
     }
 };
 
-void printSquare(const vector<vector<int>>& square) {
-    cout << "\n";
+void printSquare(const vector<vector<int>>& square, ostream& out = cout) {
+    out << "\n";
     int x = square.size();
     for (int i = 0; i < x; i++) {
         for (int j = 0; j < x; j++) {
-            cout << square[i][j] << " "; // Print each element
+            out << square[i][j] << " "; // Print each element
         }
-        cout << "\n"; // New line after each row
+        out << "\n"; // New line after each row
     }
-    cout << "\n";
+    out << "\n";
 }
 
+/**
+ * @brief Collects the solutions of the attempt threads and tells them when to stop.
+ *
+ * Threads add solutions under a lock; once the target number of distinct solutions is
+ * reached the cancel flag is raised, which running attempts poll between independent sets.
+ * A target of 0 never raises it.
+ */
+class Collector {
+public:
+    atomic<bool> cancel{false}; // Raised once the target, if any, is reached
+    set<vector<vector<int>>> solutions; // Read once every thread has stopped
+
+    Collector(size_t target) : target(target) {
+        ;
+    }
+
+    /**
+     * @brief Records a solution, raising the cancel flag if it completes the target.
+     */
+    void add(const vector<vector<int>>& square) {
+        lock_guard<mutex> guard(lock);
+        solutions.insert(square);
+        if (target > 0 && solutions.size() >= target) cancel.store(true, memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns true once the target is reached.
+     */
+    bool done() const {
+        return cancel.load(memory_order_relaxed);
+    }
+
+private:
+    mutex lock;
+    size_t target;
+};
+
 int main(int argc, char *argv[]) {
     int num_threads = 16; // Default number of threads
-    if (argc > 1)
+    int inner = 1; // Threads extracting the independent sets of one attempt
+    int target = 0; // Distinct solutions to stop at; if 0, every attempt thread stops at its own first
+    string engine = "mis"; // Colouring of one attempt, mis or dsatur
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--inner" && i + 1 < argc) inner = max(1, stoi(argv[++i]));
+        else if (arg == "--solutions" && i + 1 < argc) target = max(1, stoi(argv[++i]));
+        else if (arg == "--first") target = 1;
+        else if (arg == "--engine" && i + 1 < argc) engine = argv[++i];
+        else args.push_back(arg);
+    }
+    if (args.size() > 0)
     {
-        num_threads = stoi(argv[1]);
+        num_threads = stoi(args[0]);
     }
-    omp_set_num_threads(num_threads);
-    LSC x = LSC(
-        {{1, 0, 0, 0},
-         {0, 0, 0, 0},
-         {0, 0, 0, 0},
-         {3, 0, 0, 0},
-        }
-    
-    // 7x7
-    // {{1, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0},
-    //  {3, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0}}
-
-    // 8x8
-    // {{1, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 2, 0, 0, 0, 0, 0, 0},
-    //  {3, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 4, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 5, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 6},
-    //  {0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 8}}
-
-    //9x9
-    // {{1, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 2, 0, 0, 0, 0, 0, 0, 0},
-    //  {3, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 4, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 5, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 8},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0}}
-
-    //10x10
-    // {{1, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 2, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {3, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 4, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 5, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 6},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 5, 0, 0, 0, 9, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 10}}
-
-    // 11x11
-    // {{1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 5, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
-    //  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9}}
-
-    );
+    string path = (args.size() > 1) ? args[1] : "-"; // Instance file, stdin by default
+    if (engine != "mis" && engine != "dsatur")
+    {
+        cout << "Unknown engine " << engine << ", use mis or dsatur\n";
+        return 1;
+    }
+    if (engine == "dsatur") inner = 1; // DSATUR colours one cell at a time
+    inner = min(inner, num_threads);
+    int outer = num_threads / inner; // Attempts run at once
+    omp_set_max_active_levels(inner > 1 ? 2 : 1);
+    omp_set_num_threads(outer);
 
     std::chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
-
-    set<vector<vector<int>>> res;
-
-    # pragma omp parallel for
-    for (int i=0; i<num_threads; i++) {
-        long int max_iterations = 50000; // Limit retries
-        long int attempts = 0;
-        while (true) {
-            LSC curr = LSC(x.square);
-            curr.gen_solns();
-            if (curr.count_zero() == 0) {
-                // curr.printSquare();
-                res.insert(curr.square);
-                break;
-            }
-            // if (attempts % 1000 == 0) std::cout << "Attempt " << attempts << ": Remaining conflicts = " << curr.count_zero() << "\n";
-            attempts++;
-            if (attempts == max_iterations) {
-                // cout << "Failed\n";
-                // curr.printSquare();
-                break;
+    // Every instance already uses all threads, so instances are solved one at a time
+    long count = run_batch(path, 1, [&](long id, const vector<vector<int>>& partial, ostream& out) {
+        STATS_RESET();
+        omp_set_num_threads(outer); // The worker thread does not inherit the setting
+        omp_set_max_active_levels(inner > 1 ? 2 : 1);
+        LSC x = LSC(partial);
+        if (!x.error.empty()) {
+            out << x.error;
+            return;
+        }
+        auto start = std::chrono::system_clock::now();
+
+        Collector res(target);
+        long total_attempts = 0;
+
+        Snapshot root(x); // The preprocessed state every attempt starts from
+
+        # pragma omp parallel for reduction(+:total_attempts)
+        for (int i=0; i<outer; i++) {
+            long int max_iterations = 50000; // Limit retries
+            Attempt curr(root, inner);
+            for (long int attempts = 0; attempts < max_iterations && !res.done(); attempts++) {
+                curr.restore();
+                if (engine == "dsatur") curr.gen_dsatur(i * max_iterations + attempts, &res.cancel);
+                else curr.gen_solns(i * max_iterations + attempts, &res.cancel);
+                total_attempts++;
+                if (curr.count_zero() == 0) {
+                    res.add(curr.square());
+                    if (target == 0) break; // Its own first solution ends the thread
+                    continue;
+                }
+                // if (attempts % 1000 == 0) out << "Attempt " << attempts << ": Remaining conflicts = " << curr.count_zero() << "\n";
+                STATS_COUNT(RESTARTS);
             }
         }
-    }
 
-    end = std::chrono::system_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end - start;
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
 
-    cout << "Unique solutions: \n";
+        out << "Unique solutions: \n";
 
-    for (vector<vector<int>> x: res) {
-        printSquare(x);
-    }
+        for (vector<vector<int>> x: res.solutions) {
+            printSquare(x, out);
+        }
 
-    std::cout << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+        out << "Attempts: " << total_attempts << "\n";
+        out << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
+    end = std::chrono::system_clock::now();
 
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
     return 0;
 }
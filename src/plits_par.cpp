@@ -1,72 +1,261 @@
 #include <omp.h>
+#include <atomic>
 #include "plits.hpp"
+#include "io.hpp"
 
 using namespace std;
 
 /**
- * @brief Executes the PLITS algorithm to optimize the given LSC.
+ * @brief An elite solution sent from one island to the next.
+ */
+struct Migrant {
+    int empty; // f() of the solution
+    int conflicts; // CL() of the solution
+    vector<uint8_t> grid; // The solution, row-major
+};
+
+/**
+ * @brief Lock-free single-slot mailbox between neighbouring islands of the ring.
  *
- * @param S The initial LSC structure to optimize.
- * @return LSC The best solution found after optimization.
+ * Only the latest migrant is kept: sending swaps it in and frees the one it replaces,
+ * taking swaps in nothing. Both are a single exchange, so a migrant has one owner.
  */
-LSC PLITS(LSC S, int& steps)
-{
-    priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare> Open;
-    srand(time(0));
-    int T = (rand() % 9) + 0.6 * (S.V[0].size() + S.CL());
-    map<vector<vector<int>>, int> tabu_list;
-    LSC final = S;
-    float phi = 1;
+class Inbox {
+public:
+    atomic<Migrant*> slot{nullptr};
 
-    Open.push({S, S.F(phi)});
+    ~Inbox() {
+        delete slot.load();
+    }
 
-    // First phase of the PLITS algorithm
-    for (int i = 0; i < (50 * S.V.size()) && !Open.empty(); i++)
-    {
-        steps++;
-        auto curr = Open.top();
-        Open.pop();
-        curr.first.MoveGen(phi, T, Open, tabu_list);
+    void send(Migrant* m) {
+        delete slot.exchange(m, memory_order_acq_rel);
+    }
 
-        // Decrease the tabu tenure for all entries in the tabu list
-        for (auto &It : tabu_list)
-        {
-            It.second--;
+    Migrant* take() {
+        return slot.exchange(nullptr, memory_order_acquire);
+    }
+};
+
+/**
+ * @brief One PLITS trajectory of the island model.
+ *
+ * Runs the two PLITS phases of the original search, 50 |V| iterations with phi = 1 and
+ * 300 |V| with phi = 10 |V|, on one random start, in slices of a migration interval.
+ * Each island draws its tenure and tie-breaks from its own engine, so its trajectory does
+ * not depend on the other threads.
+ */
+class Island {
+public:
+    LSC curr; // The current state
+    LSC best; // The best state found so far
+    long iter = 0; // Iterations done
+    long improved = 0; // Iteration of the last improvement of best
+
+    Island(const LSC& S, seed_seq& seed) : curr(S), best(S), tabu(S.square.size()), rng(seed) {
+        T = (rng() % 9) + 0.6 * (curr.V[0].size() + curr.CL());
+        switch_at = 50 * curr.V.size();
+        budget = 350 * curr.V.size();
+        phase2_phi = 10 * curr.V.size();
+    }
+
+    /**
+     * @brief Checks if the island has used its iteration budget.
+     */
+    bool exhausted() const {
+        return iter >= budget;
+    }
+
+    /**
+     * @brief Checks if best completes the square: no conflicts and no empty cell.
+     */
+    bool solved() {
+        return best.CL() == 0 && best.count_zero() == 0;
+    }
+
+    /**
+     * @brief Runs up to k iterations, stopping at a solution.
+     *
+     * @return true if best is a solution.
+     */
+    bool run(long k) {
+        if (solved()) return true; // The start, or a migrant, may already be one
+        while (k > 0 && !exhausted()) {
+            // Slices never cross the phase switch, so every slice is timed as one phase
+            long stop = min(iter + k, iter < switch_at ? switch_at : budget);
+            k -= stop - iter;
+            bool solved;
+            if (iter < switch_at) {
+                STATS_PHASE(PHASE1);
+                solved = search(1, stop);
+            } else {
+                STATS_PHASE(PHASE2);
+                solved = search(phase2_phi, stop);
+            }
+            if (solved) return true;
         }
+        return false;
+    }
 
-        if (final.F(phi) > curr.first.F(phi))
-        {
-            final = curr.first;
-            if (final.GoalTest()) return final;
+    /**
+     * @brief Checks if best has not improved for the given number of iterations.
+     */
+    bool stagnant(long window) const {
+        return iter - improved >= window;
+    }
+
+    /**
+     * @brief Copies best into a migrant.
+     */
+    Migrant* emigrate() {
+        int x = best.square.size();
+        Migrant* m = new Migrant{best.f(), best.CL(), vector<uint8_t>(x * x)};
+        for (int i = 0; i < x; i++) {
+            for (int j = 0; j < x; j++) m->grid[i * x + j] = best.square[i][j];
         }
+        return m;
     }
 
-    phi = 10 * S.V.size();
-    Open = priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>();
-    tabu_list.clear();
-    Open.push({S, S.F(phi)});
+    /**
+     * @brief Restarts the trajectory from a migrant, with an empty tabu list.
+     *
+     * The migrant comes from the same instance, so only the free cells differ; they are
+     * moved one by one to keep the color classes and conflict counters of curr. The
+     * migrant also replaces best if it scores better under the current phi.
+     */
+    void immigrate(const Migrant& m) {
+        int x = curr.square.size();
+        for (auto& v : curr.Cand_set) {
+            int old_color = curr.square[v.first][v.second], color = m.grid[v.first * x + v.second];
+            if (old_color != color) curr.Move(v, old_color, color);
+        }
+        tabu.clear();
+        tabu_base = iter;
+        improved = iter;
+        float phi = iter < switch_at ? 1 : phase2_phi;
+        if (m.empty + phi * m.conflicts < best.F(phi)) best = curr;
+    }
 
-    // Second phase of the PLITS algorithm
-    for (int i = 0; i < (300 * S.V.size()) && !Open.empty(); i++)
-    {
-        steps++;
-        auto curr = Open.top();
-        Open.pop();
-        curr.first.MoveGen(phi, T, Open, tabu_list);
+private:
+    TabuList tabu;
+    int T; // Tabu tenure
+    long tabu_base = 0; // Iteration the tabu list was last cleared at
+    long switch_at; // Iteration of the switch to the second phase
+    long budget; // Total iterations
+    float phase2_phi;
+    mt19937 rng;
 
-        for (auto &It : tabu_list)
-        {
-            It.second--;
+    bool search(float phi, long stop) {
+        pair<int, int> cell;
+        int color;
+        for (; iter < stop; iter++) {
+            int i = iter - tabu_base; // Tabu expiries count from the last clear
+            if (!curr.BestMove(phi, tabu, i, best.F(phi), cell, color, rng)) {
+                iter = budget; // No allowed move, the island is done
+                return solved();
+            }
+            int old_color = curr.square[cell.first][cell.second];
+            curr.Move(cell, old_color, color); // Apply the move in place
+
+            // Forbid moving the cell back to its old color for the next T iterations
+            tabu.add(cell, old_color, i + 1 + T);
+
+            if (best.F(phi) > curr.F(phi)) {
+                best = curr;
+                improved = iter;
+                if (solved()) {
+                    iter++;
+                    return true;
+                }
+            }
         }
+        return false;
+    }
+};
 
-        if (final.F(phi) > curr.first.F(phi))
+/**
+ * @brief Runs island-model PLITS: one trajectory per start, on a ring of islands.
+ *
+ * The search goes in epochs. In each, the threads advance the islands they own
+ * (round-robin) by one migration interval; then every island sends its best state to
+ * the inbox of the next island, and an island whose best has not improved for
+ * STAGNATION intervals restarts from the migrant in its own inbox. Barriers separate the
+ * steps, so with a fixed seed the result does not depend on the number of threads. The
+ * search stops after the first epoch that finds a solution, or when every island has
+ * used its budget.
+ *
+ * @param starts The initial states, one per island.
+ * @param threads The number of threads.
+ * @param interval The number of iterations between migrations.
+ * @param seed Seeds the engines of the islands.
+ * @param solutions Receives the solutions found.
+ * @param migrations Set to the number of restarts from a migrant.
+ * @return The total number of iterations over all islands.
+ */
+long Islands(const vector<LSC>& starts, int threads, long interval, unsigned seed, set<vector<vector<int>>>& solutions, long& migrations)
+{
+    const long STAGNATION = 5;
+    int k = starts.size();
+    vector<Island> islands;
+    islands.reserve(k);
+    for (int i = 0; i < k; i++)
+    {
+        seed_seq seq{seed, (unsigned)i};
+        islands.emplace_back(starts[i], seq);
+    }
+    vector<Inbox> inbox(k);
+    vector<char> solved(k, 0);
+    bool done = false;
+    atomic<long> restarts(0);
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num(), p = omp_get_num_threads();
+        while (true)
         {
-            final = curr.first;
-            if (final.GoalTest()) return final;
+            for (int i = t; i < k; i += p)
+            {
+                if (!islands[i].exhausted()) solved[i] = islands[i].run(interval);
+            }
+            # pragma omp barrier
+            # pragma omp single
+            {
+                bool active = false;
+                for (int i = 0; i < k; i++)
+                {
+                    if (solved[i]) solutions.insert(islands[i].best.square);
+                    active |= !islands[i].exhausted();
+                }
+                done = !solutions.empty() || !active;
+            }
+            if (done) break;
+
+            for (int i = t; i < k; i += p)
+            {
+                if (!islands[i].exhausted()) inbox[(i + 1) % k].send(islands[i].emigrate());
+            }
+            # pragma omp barrier
+            for (int i = t; i < k; i += p)
+            {
+                Island& I = islands[i];
+                if (I.exhausted() || !I.stagnant(STAGNATION * interval)) continue;
+                Migrant* m = inbox[i].take();
+                if (m != nullptr)
+                {
+                    STATS_COUNT(RESTARTS);
+                    I.immigrate(*m);
+                    restarts++;
+                    delete m;
+                }
+            }
+            # pragma omp barrier
         }
     }
 
-    return final;
+    migrations = restarts;
+    long steps = 0;
+    for (auto& I : islands) steps += I.iter;
+    return steps;
 }
 
 int main(int argc, char *argv[])
@@ -77,59 +266,85 @@ int main(int argc, char *argv[])
         num_threads = stoi(argv[1]);
     }
     omp_set_num_threads(num_threads);
-
-    cout << "Number of threads: " << omp_get_max_threads() << endl;
-
-    LSC test(
-        // {{3, 0, 0, 0, 0},
-        //  {0, 0, 0, 2, 0},
-        //  {0, 0, 1, 0, 0},
-        //  {0, 0, 0, 0, 0},
-        //  {0, 0, 0, 1, 0},
-        // }
-        {{1, 0, 0, 0},
-         {0, 0, 0, 0},
-         {0, 0, 0, 0},
-         {3, 0, 0, 0},
+    string path = (argc > 2) ? argv[2] : "-"; // Instance file, stdin by default
+    int num_islands = num_threads; // One island per thread by default
+    long interval = 100; // Iterations between migrations
+    bool speedup = false; // Also run on one thread and report the speedup
+    for (int i = 3; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--islands" && i + 1 < argc) num_islands = stoi(argv[++i]);
+        else if (arg == "--interval" && i + 1 < argc) interval = stol(argv[++i]);
+        else if (arg == "--speedup") speedup = true;
+        else
+        {
+            cout << "Usage: " << argv[0] << " [threads] [file] [--islands k] [--interval iterations] [--speedup]\n";
+            return 1;
         }
-        // {{3, 0, 0},
-        //  {0, 0, 0},
-        //  {1, 0, 0}}
-    );
+    }
+    if (num_islands < 1 || interval < 1)
+    {
+        cout << "Islands and interval must be positive\n";
+        return 1;
+    }
+    unsigned seed = run_seed(time(0));
+
+    cout << "Number of threads: " << omp_get_max_threads() << ", islands: " << num_islands << ", migration interval: " << interval << endl;
 
     std::chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
-
-    vector<LSC> res = test.gen_population(5);
-    // for (LSC &i : res)       // Printing the intermediate states
-    // {
-    //     i.printSquare();
-    //     cout << "\n";
-    // }
-    set<vector<vector<int>>> imp;
-    int global_steps = 0;
-    #pragma omp parallel for
-    for (LSC &i : res)
+    // Every instance already uses all threads, so instances are solved one at a time
+    long count = run_batch(path, 1, [&](long id, const vector<vector<int>>& partial, ostream& out)
     {
-        int steps = 0;
-        LSC temp = PLITS(i, steps);
-        #pragma omp critical
-        global_steps += steps;
-        if (temp.count_zero() == 0)
-            imp.insert(temp.square);
-    }
+        STATS_RESET();
+        omp_set_num_threads(num_threads);
+        LSC test(partial);
+        if (!test.error.empty())
+        {
+            out << test.error;
+            return;
+        }
+        vector<LSC> starts = test.gen_population(num_islands, seed + id);
 
-    cout << "Unique solutions: \n";
+        // Sequential baseline: the same islands, interleaved on a single thread
+        std::chrono::duration<double> seq_seconds(0);
+        if (speedup)
+        {
+            set<vector<vector<int>>> ignored;
+            long ignored_migrations;
+            auto start = std::chrono::system_clock::now();
+            long seq_steps = Islands(starts, 1, interval, seed + id, ignored, ignored_migrations);
+            seq_seconds = std::chrono::system_clock::now() - start;
+            out << "Sequential: " << seq_steps << " steps, " << seq_seconds.count() << "s\n";
+        }
 
-    for (auto &i : imp)
-    {
-        printSquare(i);
-        cout << "\n";
-    }
+        auto start = std::chrono::system_clock::now();
+        set<vector<vector<int>>> imp;
+        long migrations = 0;
+        long global_steps = Islands(starts, num_threads, interval, seed + id, imp, migrations);
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
 
+        out << "Unique solutions: \n";
+
+        for (auto &i : imp)
+        {
+            printSquare(i, out);
+            out << "\n";
+        }
+
+        out << "Migrations: " << migrations << "\n";
+        if (speedup)
+        {
+            double s = seq_seconds.count() / elapsed_seconds.count();
+            out << "Speedup: " << s << "x, per core: " << s / num_threads << "\n";
+        }
+        out << "Steps taken: " << global_steps << "\n";
+        out << "elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
     end = std::chrono::system_clock::now();
+
     std::chrono::duration<double> elapsed_seconds = end - start;
-    cout << "Steps taken (average): " << global_steps << "\n";
-    std::cout << "elapsed time: " << elapsed_seconds.count() << "s\n";
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
     return 0;
 }
@@ -1,4 +1,5 @@
 #include "plits.hpp"
+#include "io.hpp"
 
 using namespace std;
 
@@ -6,62 +7,61 @@ using namespace std;
  * @brief Executes the PLITS algorithm to optimize the given LSC.
  *
  * @param S The initial LSC structure to optimize.
+ * @param seed Seeds the tabu tenure and the tie-breaks.
  * @return LSC The best solution found after optimization.
  */
-LSC PLITS(LSC S, int& steps)
+LSC PLITS(LSC S, int& steps, unsigned seed)
 {
-    priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare> Open;
-    srand(time(0));
-    int T = (rand() % 9) + 0.6 * (S.V[0].size() + S.CL());
-    map<vector<vector<int>>, int> tabu_list;
+    mt19937 rng(seed);
+    int T = (rng() % 9) + 0.6 * (S.V[0].size() + S.CL());
+    TabuList tabu_list(S.square.size());
     LSC final = S;
+    LSC curr = S;
     float phi = 1;
-
-    Open.push({S, S.F(phi)});
+    pair<int, int> cell;
+    int color;
 
     // First phase of the PLITS algorithm
-    for (int i = 0; i < (100 * S.V.size()) && !Open.empty(); i++)
     {
-        steps++;
-        auto curr = Open.top();
-        Open.pop();
-        curr.first.MoveGen(phi, T, Open, tabu_list);
-
-        // Decrease the tabu tenure for all entries in the tabu list
-        for (auto &It : tabu_list)
-        {
-            It.second--;
-        }
-
-        if (final.F(phi) > curr.first.F(phi))
+        STATS_PHASE(PHASE1);
+        for (int i = 0; i < (100 * S.V.size()); i++)
         {
-            final = curr.first;
-            if (final.GoalTest()) return final;
+            steps++;
+            if (!curr.BestMove(phi, tabu_list, i, final.F(phi), cell, color, rng)) break;
+            int old_color = curr.square[cell.first][cell.second];
+            curr.Move(cell, old_color, color); // Apply the move in place
+
+            // Forbid moving the cell back to its old color for the next T iterations
+            tabu_list.add(cell, old_color, i + 1 + T);
+
+            if (final.F(phi) > curr.F(phi))
+            {
+                final = curr;
+                if (final.GoalTest()) return final;
+            }
         }
     }
 
     phi = 10 * S.V.size();
-    Open = priority_queue<pair<LSC, int>, vector<pair<LSC, int>>, Compare>();
+    curr = S;
     tabu_list.clear();
-    Open.push({S, S.F(phi)});
 
     // Second phase of the PLITS algorithm
-    for (int i = 0; i < (300 * S.V.size()) && !Open.empty(); i++)
     {
-        steps++;
-        auto curr = Open.top();
-        Open.pop();
-        curr.first.MoveGen(phi, T, Open, tabu_list);
-
-        for (auto &It : tabu_list)
+        STATS_PHASE(PHASE2);
+        for (int i = 0; i < (300 * S.V.size()); i++)
         {
-            It.second--;
-        }
-
-        if (final.F(phi) > curr.first.F(phi))
-        {
-            final = curr.first;
-            if (final.GoalTest()) return final;
+            steps++;
+            if (!curr.BestMove(phi, tabu_list, i, final.F(phi), cell, color, rng)) break;
+            int old_color = curr.square[cell.first][cell.second];
+            curr.Move(cell, old_color, color);
+            tabu_list.add(cell, old_color, i + 1 + T);
+
+            if (final.F(phi) > curr.F(phi))
+            {
+                final = curr;
+                if (final.GoalTest()) return final;
+            }
         }
     }
 
@@ -114,57 +114,58 @@ vector<vector<int>> dist_matrix_calc(vector<LSC> &init_pop, vector<LSC> &improve
     return res;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    LSC test(
-        {{3, 0, 0, 0, 0},
-         {0, 0, 0, 2, 0},
-         {0, 0, 1, 0, 0},
-         {0, 0, 0, 0, 0},
-         {0, 0, 0, 1, 0},
-        }
-        // {{1, 0, 0, 0},
-        //  {0, 0, 0, 4},
-        //  {0, 2, 0, 0},
-        //  {3, 0, 0, 0},
-        // }
-        //
-        // {{3, 0, 0},
-        //  {0, 0, 0},
-        //  {1, 0, 0}}
-        );
+    string path = (argc > 1) ? argv[1] : "-"; // Instance file, stdin by default
+    int workers = (argc > 2) ? stoi(argv[2]) : thread::hardware_concurrency(); // Instances solved at once
 
     std::chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
-
-    vector<LSC> res = test.gen_population(5);
-    // for (LSC &i : res)       // Printing the intermediate states
-    // {
-    //     i.printSquare();
-    //     cout << "\n";
-    // }
-    vector<LSC> imp;
-    int steps = 0, global_steps = 0;
-    for (LSC &i : res)
+    long count = run_batch(path, workers, [&](long id, const vector<vector<int>>& partial, ostream& out)
     {
-        LSC temp = PLITS(i, steps);
-        cout << "Steps:" << steps << "\n";
-        global_steps += steps;
-        steps = 0;
-        imp.push_back(temp);
-    }
+        STATS_RESET();
+        unsigned seed = run_seed(time(0)) + id; // Workers draw from their own engines
+        LSC test(partial);
+        if (!test.error.empty())
+        {
+            out << test.error;
+            return;
+        }
+        auto start = std::chrono::system_clock::now();
+
+        vector<LSC> res = test.gen_population(5, seed);
+        // for (LSC &i : res)       // Printing the intermediate states
+        // {
+        //     i.printSquare(out);
+        //     out << "\n";
+        // }
+        vector<LSC> imp;
+        int steps = 0, global_steps = 0;
+        for (size_t k = 0; k < res.size(); k++)
+        {
+            LSC temp = PLITS(res[k], steps, seed + 1 + k);
+            out << "Steps:" << steps << "\n";
+            global_steps += steps;
+            steps = 0;
+            imp.push_back(temp);
+        }
 
-    cout << "Solutions: \n";
+        out << "Solutions: \n";
 
-    for (auto &i : imp)
-    {
-        i.printSquare();
-        cout << "\n";
-    }
+        for (auto &i : imp)
+        {
+            i.printSquare(out);
+            out << "\n";
+        }
 
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+        out << "Steps taken: " << global_steps << "\n";
+        out << "elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
     end = std::chrono::system_clock::now();
+
     std::chrono::duration<double> elapsed_seconds = end - start;
-    cout << "Steps taken (average): " << global_steps << "\n";
-    cout << "elapsed time: " << elapsed_seconds.count() << "s\n";
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
     return 0;
 }
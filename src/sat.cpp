@@ -0,0 +1,179 @@
+#include <fstream>
+#include "lsc.hpp"
+#include "sat.hpp"
+#include "io.hpp"
+
+using namespace std;
+
+/**
+ * @brief Encodes the completion of an LSC instance as CNF.
+ *
+ * A variable (i, j, s) exists only for a free cell and a symbol left in its filtered
+ * domain. Every cell, every (row, symbol) and every (column, symbol) pair gets one
+ * at-least-one clause over its variables, so unit propagation sees all three conjugate
+ * views of the square. Every cell also gets pairwise at-most-one clauses.
+ *
+ * The direct encoding states that two free cells of a row or column differ with pairwise
+ * at-most-one clauses per (row, symbol) and (column, symbol). The support encoding states
+ * it instead with one clause per cell, symbol and neighbour: if the cell takes s, the
+ * neighbour takes one of its other symbols. Unit propagation then enforces arc
+ * consistency on every pair of neighbours, at the cost of longer clauses.
+ *
+ * @param S The LSC instance; its free cells are the ones in Cand_set.
+ * @param solver The solver that receives the clauses.
+ * @param support Use the support encoding instead of the direct one.
+ * @return The variable of every candidate, indexed by (i * x + j) * (x + 1) + s, 0 if none.
+ */
+vector<int> encode(const LSC& S, SAT& solver, bool support)
+{
+    int x = S.square.size();
+    vector<int> var(x * x * (x + 1), 0);
+    for (auto &cell : S.Cand_set)
+    {
+        uint64_t mask = S.D.mask(cell);
+        for (int s = 1; s <= x; s++)
+        {
+            if ((mask >> s) & 1) var[(cell.first * x + cell.second) * (x + 1) + s] = solver.new_var();
+        }
+    }
+
+    auto exactly_one = [&](const vector<int>& group, bool pairwise) {
+        solver.add_clause(group);
+        for (size_t a = 0; pairwise && a < group.size(); a++)
+        {
+            for (size_t b = a + 1; b < group.size(); b++)
+            {
+                solver.add_clause({-group[a], -group[b]});
+            }
+        }
+    };
+
+    vector<int> group;
+    for (auto &cell : S.Cand_set)
+    {
+        group.clear();
+        for (int s = 1; s <= x; s++)
+        {
+            int v = var[(cell.first * x + cell.second) * (x + 1) + s];
+            if (v != 0) group.push_back(v);
+        }
+        exactly_one(group, true);
+    }
+    for (int k = 0; k < x; k++)
+    {
+        for (int s = 1; s <= x; s++)
+        {
+            // Rows and columns that already hold s need no clause
+            if (!((S.D.row_used[k] >> s) & 1))
+            {
+                group.clear();
+                for (int j = 0; j < x; j++)
+                {
+                    if (var[(k * x + j) * (x + 1) + s] != 0) group.push_back(var[(k * x + j) * (x + 1) + s]);
+                }
+                exactly_one(group, !support);
+            }
+            if (!((S.D.col_used[k] >> s) & 1))
+            {
+                group.clear();
+                for (int i = 0; i < x; i++)
+                {
+                    if (var[(i * x + k) * (x + 1) + s] != 0) group.push_back(var[(i * x + k) * (x + 1) + s]);
+                }
+                exactly_one(group, !support);
+            }
+        }
+    }
+    if (!support) return var;
+
+    vector<int> clause;
+    for (auto &v : S.Cand_set)
+    {
+        for (auto &u : S.Cand_set)
+        {
+            // Neighbours share a row or a column
+            if (u == v || (u.first != v.first && u.second != v.second)) continue;
+            for (int s = 1; s <= x; s++)
+            {
+                int a = var[(v.first * x + v.second) * (x + 1) + s];
+                if (a == 0) continue;
+                clause.assign(1, -a);
+                for (int t = 1; t <= x; t++)
+                {
+                    int b = var[(u.first * x + u.second) * (x + 1) + t];
+                    if (t != s && b != 0) clause.push_back(b);
+                }
+                solver.add_clause(clause);
+            }
+        }
+    }
+    return var;
+}
+
+int main(int argc, char *argv[])
+{
+    bool support = false; // Support encoding of the row and column constraints
+    vector<string> args;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--support") support = true;
+        else args.push_back(arg);
+    }
+    string path = (args.size() > 0) ? args[0] : "-"; // Instance file, stdin by default
+    int workers = (args.size() > 1) ? stoi(args[1]) : thread::hardware_concurrency(); // Instances solved at once
+    string dimacs = (args.size() > 2) ? args[2] : ""; // Optional prefix of the DIMACS files
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    start = std::chrono::system_clock::now();
+    long count = run_batch(path, workers, [&](long id, const vector<vector<int>>& partial, ostream& out)
+    {
+        STATS_RESET();
+        auto start = std::chrono::system_clock::now();
+        LSC S(partial, run_seed(time(0)) + id);
+        if (!S.error.empty())
+        {
+            out << S.error;
+            return;
+        }
+        int x = S.square.size();
+        SAT solver;
+        vector<int> var = encode(S, solver, support);
+        if (!dimacs.empty())
+        {
+            // Optional DIMACS export of the encoding, one file per instance
+            ofstream cnf(dimacs + to_string(id) + ".cnf");
+            solver.write_dimacs(cnf);
+        }
+        out << "Variables: " << solver.vars() << ", clauses: " << solver.clauses() << "\n";
+        bool solved = solver.solve();
+        std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start;
+
+        if (solved)
+        {
+            for (auto &cell : S.Cand_set)
+            {
+                for (int s = 1; s <= x; s++)
+                {
+                    int v = var[(cell.first * x + cell.second) * (x + 1) + s];
+                    if (v != 0 && solver.model[v - 1]) S.square[cell.first][cell.second] = s;
+                }
+            }
+            out << "Soln\n";
+            S.printSquare(out);
+        }
+        else
+        {
+            out << "Given Partial Latin Square cannot be solved\n";
+        }
+        out << "Decisions: " << solver.decisions << ", conflicts: " << solver.conflicts << ", propagations: " << solver.propagations
+            << ", restarts: " << solver.restarts << ", reductions: " << solver.reductions << "\n";
+        out << "Elapsed time: " << elapsed_seconds.count() << "s\n";
+        STATS_REPORT(out);
+    });
+    end = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Instances: " << count << ", total elapsed time: " << elapsed_seconds.count() << "s\n";
+    return 0;
+}